@@ -51,6 +51,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include <QtCore/QBuffer>
 #include <QtGui/QFontDatabase>
 
+#include <numeric>
+
 #ifdef OS_MAC_OLD
 #include <libexif/exif-data.h>
 #endif // OS_MAC_OLD
@@ -77,6 +79,82 @@ QImage cornersMaskLarge[4], cornersMaskSmall[4];
 
 int32 serviceImageCacheSize = 0;
 
+QImage ReadImage(
+		not_null<QIODevice*> device,
+		QByteArray *format,
+		bool opaque,
+		bool *animated,
+		int box,
+		QSize *original) {
+	QByteArray tmpFormat;
+	QImage result;
+	if (!format) {
+		format = &tmpFormat;
+	}
+	{
+		QImageReader reader(device, *format);
+#ifndef OS_MAC_OLD
+		reader.setAutoTransform(true);
+#endif // OS_MAC_OLD
+		if (animated) *animated = reader.supportsAnimation() && reader.imageCount() > 1;
+		if (!reader.canRead()) {
+			return QImage();
+		}
+		const auto imageSize = reader.size();
+		if (imageSize.width() * imageSize.height() > kImageAreaLimit) {
+			return QImage();
+		}
+		if (original) {
+			*original = imageSize;
+		}
+		if (box > 0
+			&& (imageSize.width() > box || imageSize.height() > box)) {
+			// JPEG is decoded right at a reduced scale this way.
+			reader.setScaledSize(imageSize.scaled(
+				box,
+				box,
+				Qt::KeepAspectRatio));
+		}
+		QByteArray fmt = reader.format();
+		if (!fmt.isEmpty()) *format = fmt;
+		if (!reader.read(&result)) {
+			return QImage();
+		}
+		fmt = reader.format();
+		if (!fmt.isEmpty()) *format = fmt;
+	}
+	auto fmt = QString::fromUtf8(*format).toLower();
+	if (fmt == "jpg" || fmt == "jpeg") {
+#ifdef OS_MAC_OLD
+		device->seek(0);
+		const auto data = device->readAll();
+		if (auto exifData = exif_data_new_from_data((const uchar*)(data.constData()), data.size())) {
+			auto byteOrder = exif_data_get_byte_order(exifData);
+			if (auto exifEntry = exif_data_get_entry(exifData, EXIF_TAG_ORIENTATION)) {
+				auto orientationFix = [exifEntry, byteOrder] {
+					auto orientation = exif_get_short(exifEntry->data, byteOrder);
+					switch (orientation) {
+					case 2: return QTransform(-1, 0, 0, 1, 0, 0);
+					case 3: return QTransform(-1, 0, 0, -1, 0, 0);
+					case 4: return QTransform(1, 0, 0, -1, 0, 0);
+					case 5: return QTransform(0, -1, -1, 0, 0, 0);
+					case 6: return QTransform(0, 1, -1, 0, 0, 0);
+					case 7: return QTransform(0, 1, 1, 0, 0, 0);
+					case 8: return QTransform(0, -1, 1, 0, 0, 0);
+					}
+					return QTransform();
+				};
+				result = result.transformed(orientationFix());
+			}
+			exif_data_free(exifData);
+		}
+#endif // OS_MAC_OLD
+	} else if (opaque) {
+		result = Images::prepareOpaque(std::move(result));
+	}
+	return result;
+}
+
 } // namespace
 
 namespace App {
@@ -323,64 +401,97 @@ namespace App {
 		if (data.isEmpty()) {
 			return QImage();
 		}
-		QByteArray tmpFormat;
-		QImage result;
 		QBuffer buffer(&data);
-		if (!format) {
-			format = &tmpFormat;
+		return ReadImage(
+			&buffer,
+			format,
+			opaque,
+			animated,
+			0,
+			nullptr);
+	}
+
+	ImagePyramid readImagePyramid(
+			QByteArray data,
+			const std::vector<int> &boxes,
+			QByteArray *format,
+			bool opaque,
+			bool *animated) {
+		if (data.isEmpty()) {
+			return ImagePyramid();
 		}
-		{
-			QImageReader reader(&buffer, *format);
-#ifndef OS_MAC_OLD
-			reader.setAutoTransform(true);
-#endif // OS_MAC_OLD
-			if (animated) *animated = reader.supportsAnimation() && reader.imageCount() > 1;
-			if (!reader.canRead()) {
-				return QImage();
-			}
-			const auto imageSize = reader.size();
-			if (imageSize.width() * imageSize.height() > kImageAreaLimit) {
-				return QImage();
-			}
-			QByteArray fmt = reader.format();
-			if (!fmt.isEmpty()) *format = fmt;
-			if (!reader.read(&result)) {
-				return QImage();
-			}
-			fmt = reader.format();
-			if (!fmt.isEmpty()) *format = fmt;
+		QBuffer buffer(&data);
+		return readImagePyramid(&buffer, boxes, format, opaque, animated);
+	}
+
+	ImagePyramid readImagePyramid(
+			not_null<QIODevice*> device,
+			const std::vector<int> &boxes,
+			QByteArray *format,
+			bool opaque,
+			bool *animated) {
+		Expects(!boxes.empty());
+
+		auto result = ImagePyramid();
+		const auto largest = *ranges::max_element(boxes);
+		auto decoded = ReadImage(
+			device,
+			format,
+			opaque,
+			animated,
+			largest,
+			&result.original);
+		if (decoded.isNull()) {
+			return result;
 		}
-		buffer.seek(0);
-		auto fmt = QString::fromUtf8(*format).toLower();
-		if (fmt == "jpg" || fmt == "jpeg") {
-#ifdef OS_MAC_OLD
-			if (auto exifData = exif_data_new_from_data((const uchar*)(data.constData()), data.size())) {
-				auto byteOrder = exif_data_get_byte_order(exifData);
-				if (auto exifEntry = exif_data_get_entry(exifData, EXIF_TAG_ORIENTATION)) {
-					auto orientationFix = [exifEntry, byteOrder] {
-						auto orientation = exif_get_short(exifEntry->data, byteOrder);
-						switch (orientation) {
-						case 2: return QTransform(-1, 0, 0, 1, 0, 0);
-						case 3: return QTransform(-1, 0, 0, -1, 0, 0);
-						case 4: return QTransform(1, 0, 0, -1, 0, 0);
-						case 5: return QTransform(0, -1, -1, 0, 0, 0);
-						case 6: return QTransform(0, 1, -1, 0, 0, 0);
-						case 7: return QTransform(0, 1, 1, 0, 0, 0);
-						case 8: return QTransform(0, -1, 1, 0, 0, 0);
-						}
-						return QTransform();
-					};
-					result = result.transformed(orientationFix());
-				}
-				exif_data_free(exifData);
-			}
-#endif // OS_MAC_OLD
-		} else if (opaque) {
-			result = Images::prepareOpaque(std::move(result));
+		if (result.original.isEmpty()) {
+			result.original = decoded.size();
+		} else if ((decoded.width() > decoded.height())
+			!= (result.original.width() > result.original.height())) {
+			// Auto transform has rotated the image.
+			result.original.transpose();
+		}
+
+		// Each level is scaled from the smallest already scaled one.
+		auto order = std::vector<int>(boxes.size());
+		std::iota(begin(order), end(order), 0);
+		ranges::sort(order, [&](int a, int b) {
+			return boxes[a] > boxes[b];
+		});
+		result.levels.resize(boxes.size());
+		auto source = &decoded;
+		for (const auto index : order) {
+			const auto box = boxes[index];
+			auto &level = result.levels[index];
+			level = (source->width() > box || source->height() > box)
+				? source->scaled(
+					box,
+					box,
+					Qt::KeepAspectRatio,
+					Qt::SmoothTransformation)
+				: *source;
+			source = &level;
 		}
 		return result;
 	}
 
+	ImagePyramid readImagePyramid(
+			const QString &file,
+			const std::vector<int> &boxes,
+			QByteArray *format,
+			bool opaque,
+			bool *animated) {
+		QFile f(file);
+		if (f.size() > kImageSizeLimit || !f.open(QIODevice::ReadOnly)) {
+			if (animated) *animated = false;
+			return ImagePyramid();
+		}
+
+		// Read from the file directly, so that probing a non-image file
+		// reads only its header instead of loading all of it in memory.
+		return readImagePyramid(&f, boxes, format, opaque, animated);
+	}
+
 	QImage readImage(const QString &file, QByteArray *format, bool opaque, bool *animated, QByteArray *content) {
 		QFile f(file);
 		if (f.size() > kImageSizeLimit || !f.open(QIODevice::ReadOnly)) {
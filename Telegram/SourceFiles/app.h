@@ -89,6 +89,32 @@ namespace App {
 	constexpr auto kImageSizeLimit = 64 * 1024 * 1024; // Open images up to 64mb jpg/png/gif
 	QImage readImage(QByteArray data, QByteArray *format = nullptr, bool opaque = true, bool *animated = nullptr);
 	QImage readImage(const QString &file, QByteArray *format = nullptr, bool opaque = true, bool *animated = nullptr, QByteArray *content = 0);
+
+	struct ImagePyramid {
+		std::vector<QImage> levels;
+		QSize original;
+	};
+
+	// Decodes once at close to the largest of the square boxes,
+	// levels[i] is the image scaled down to fit in boxes[i].
+	ImagePyramid readImagePyramid(
+		QByteArray data,
+		const std::vector<int> &boxes,
+		QByteArray *format = nullptr,
+		bool opaque = true,
+		bool *animated = nullptr);
+	ImagePyramid readImagePyramid(
+		not_null<QIODevice*> device,
+		const std::vector<int> &boxes,
+		QByteArray *format = nullptr,
+		bool opaque = true,
+		bool *animated = nullptr);
+	ImagePyramid readImagePyramid(
+		const QString &file,
+		const std::vector<int> &boxes,
+		QByteArray *format = nullptr,
+		bool opaque = true,
+		bool *animated = nullptr);
 	QPixmap pixmapFromImageInPlace(QImage &&image);
 
 	void complexOverlayRect(Painter &p, QRect rect, ImageRoundRadius radius, RectParts corners);
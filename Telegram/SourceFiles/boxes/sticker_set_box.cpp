@@ -307,7 +307,7 @@ void StickerSetBox::Inner::gotSet(const MTPmessages_StickerSet &set) {
 			} else {
 				_setThumbnail = ImageWithLocation();
 			}
-			const auto &sets = _controller->session().data().stickerSets();
+			auto &sets = _controller->session().data().stickerSetsRef();
 			const auto it = sets.find(_setId);
 			if (it != sets.cend()) {
 				const auto set = it->second.get();
@@ -506,7 +506,7 @@ not_null<Lottie::MultiPlayer*> StickerSetBox::Inner::getLottiePlayer() {
 	if (!_lottiePlayer) {
 		_lottiePlayer = std::make_unique<Lottie::MultiPlayer>(
 			Lottie::Quality::Default,
-			Lottie::MakeFrameRenderer());
+			Stickers::PanelsLottieRenderer());
 		_lottiePlayer->updates(
 		) | rpl::start_with_next([=] {
 			update();
@@ -1007,12 +1007,7 @@ void FieldAutocompleteInner::rowsUpdated() {
 
 auto FieldAutocompleteInner::getLottieRenderer()
 -> std::shared_ptr<Lottie::FrameRenderer> {
-	if (auto result = _lottieRenderer.lock()) {
-		return result;
-	}
-	auto result = Lottie::MakeFrameRenderer();
-	_lottieRenderer = result;
-	return result;
+	return Stickers::PanelsLottieRenderer();
 }
 
 void FieldAutocompleteInner::setupLottie(StickerSuggestion &suggestion) {
@@ -231,7 +231,6 @@ private:
 	const not_null<BotCommandRows*> _brows;
 	const not_null<StickerRows*> _srows;
 	rpl::lifetime _stickersLifetime;
-	std::weak_ptr<Lottie::FrameRenderer> _lottieRenderer;
 	int _stickersPerRow = 1;
 	int _recentInlineBotsInRows = 0;
 	int _sel = -1;
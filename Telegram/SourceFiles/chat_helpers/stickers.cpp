@@ -33,7 +33,151 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 namespace Stickers {
 namespace {
 
-constexpr auto kDontCacheLottieAfterArea = 512 * 512;
+constexpr auto kDontCacheLottieAfterArea = 1024 * 1024;
+constexpr auto kMaxCachedLottieSize = 8 * 1024 * 1024;
+constexpr auto kSortKeySlice = 65536;
+
+struct SharedPlayerKey {
+	not_null<DocumentData*> document;
+	uint8 replacementsTag = 0;
+	LottieSize sizeTag = LottieSize();
+	int width = 0;
+	int height = 0;
+	Lottie::Quality quality = Lottie::Quality();
+
+	inline bool operator<(const SharedPlayerKey &other) const {
+		return std::tie(
+			document,
+			replacementsTag,
+			sizeTag,
+			width,
+			height,
+			quality
+		) < std::tie(
+			other.document,
+			other.replacementsTag,
+			other.sizeTag,
+			other.width,
+			other.height,
+			other.quality);
+	}
+};
+
+base::flat_map<
+	SharedPlayerKey,
+	std::weak_ptr<Lottie::SinglePlayer>> SharedPlayers;
+
+std::weak_ptr<Lottie::FrameRenderer> PanelsRenderer;
+
+[[nodiscard]] EmojiIndex BuildEmojiIndex(not_null<Main::Session*> session) {
+	auto result = EmojiIndex();
+	const auto &sets = session->data().stickerSets();
+
+	const auto InstallDateAdjusted = [&](
+			TimeId date,
+			not_null<DocumentData*> document) {
+		return (document->sticker() && document->sticker()->animated)
+			? date
+			: date / 2;
+	};
+	const auto InstallDate = [&](not_null<DocumentData*> document) {
+		Expects(document->sticker() != nullptr);
+
+		const auto sticker = document->sticker();
+		if (sticker->set.type() == mtpc_inputStickerSetID) {
+			const auto setId = sticker->set.c_inputStickerSetID().vid().v;
+			const auto setIt = sets.find(setId);
+			if (setIt != sets.end()) {
+				return InstallDateAdjusted(setIt->second->installDate, document);
+			}
+		}
+		return TimeId(0);
+	};
+
+	const auto recentIt = sets.find(Stickers::CloudRecentSetId);
+	if (recentIt != sets.cend()) {
+		const auto recent = recentIt->second.get();
+		for (auto i = recent->emoji.cbegin(); i != recent->emoji.cend(); ++i) {
+			auto &list = result.lists[i.key()];
+			list.entries.reserve(i->size());
+			for (const auto document : *i) {
+				const auto usageDate = [&] {
+					if (recent->dates.empty()) {
+						return TimeId(0);
+					}
+					const auto index = recent->stickers.indexOf(document);
+					if (index < 0) {
+						return TimeId(0);
+					}
+					Assert(index < recent->dates.size());
+					return recent->dates[index];
+				}();
+				const auto date = usageDate
+					? usageDate
+					: InstallDate(document);
+				list.entries.push_back({
+					document,
+					date ? date : TimeId(kSortKeySlice * 6),
+					!date });
+				list.documents.emplace(document);
+			}
+		}
+	}
+
+	auto myCounter = 0;
+	const auto CreateMySortKey = [&](not_null<DocumentData*> document) {
+		auto base = kSortKeySlice * 6;
+		if (!document->sticker() || !document->sticker()->animated) {
+			base -= kSortKeySlice;
+		}
+		return (base - (++myCounter));
+	};
+	const auto skip = MTPDstickerSet::Flag::f_archived;
+	for (const auto setId : session->data().stickerSetsOrder()) {
+		const auto it = sets.find(setId);
+		if (it == sets.cend() || (it->second->flags & skip)) {
+			continue;
+		}
+		const auto set = it->second.get();
+		if (set->emoji.isEmpty()) {
+			result.setsToRequest.emplace(set->id, set->access);
+			set->flags |= MTPDstickerSet_ClientFlag::f_not_loaded;
+			continue;
+		}
+		const auto my = (set->flags & MTPDstickerSet::Flag::f_installed_date);
+		for (auto i = set->emoji.cbegin(); i != set->emoji.cend(); ++i) {
+			auto &list = result.lists[i.key()];
+			list.entries.reserve(list.entries.size() + i->size());
+			for (const auto document : *i) {
+				if (!list.documents.emplace(document).second) {
+					continue;
+				}
+				const auto installDate = my ? set->installDate : TimeId(0);
+				list.entries.push_back((installDate > 1)
+					? EmojiIndex::Entry{
+						document,
+						InstallDateAdjusted(installDate, document) }
+					: my
+					? EmojiIndex::Entry{ document, CreateMySortKey(document) }
+					: EmojiIndex::Entry{
+						document,
+						TimeId(kSortKeySlice * 2),
+						true });
+			}
+		}
+	}
+	return result;
+}
+
+[[nodiscard]] const EmojiIndex &EmojiIndexFor(
+		not_null<Main::Session*> session) {
+	auto &data = session->data();
+	if (!data.stickersEmojiIndex()) {
+		data.setStickersEmojiIndex(
+			std::make_unique<EmojiIndex>(BuildEmojiIndex(session)));
+	}
+	return *data.stickersEmojiIndex();
+}
 
 } // namespace
 
@@ -173,7 +317,7 @@ void InstallLocally(uint64 setId) {
 }
 
 void UndoInstallLocally(uint64 setId) {
-	const auto &sets = Auth().data().stickerSets();
+	auto &sets = Auth().data().stickerSetsRef();
 	const auto it = sets.find(setId);
 	if (it == sets.end()) {
 		return;
@@ -720,136 +864,38 @@ std::vector<not_null<DocumentData*>> GetListByEmoji(
 		not_null<EmojiPtr> emoji,
 		uint64 seed) {
 	const auto original = emoji->original();
+	const auto &index = EmojiIndexFor(session);
 
 	struct StickerWithDate {
 		not_null<DocumentData*> document;
 		TimeId date = 0;
 	};
 	auto result = std::vector<StickerWithDate>();
-	auto &sets = session->data().stickerSetsRef();
-	auto setsToRequest = base::flat_map<uint64, uint64>();
 
-	const auto add = [&](not_null<DocumentData*> document, TimeId date) {
-		if (ranges::find(result, document, [](const StickerWithDate &data) {
-			return data.document;
-		}) == result.end()) {
-			result.push_back({ document, date });
-		}
-	};
-
-	constexpr auto kSlice = 65536;
 	const auto CreateSortKey = [&](
 			not_null<DocumentData*> document,
 			int base) {
 		if (document->sticker() && document->sticker()->animated) {
-			base += kSlice;
-		}
-		return TimeId(base + int((document->id ^ seed) % kSlice));
-	};
-	const auto CreateRecentSortKey = [&](not_null<DocumentData*> document) {
-		return CreateSortKey(document, kSlice * 6);
-	};
-	auto myCounter = 0;
-	const auto CreateMySortKey = [&](not_null<DocumentData*> document) {
-		auto base = kSlice * 6;
-		if (!document->sticker() || !document->sticker()->animated) {
-			base -= kSlice;
-		}
-		return (base - (++myCounter));
-	};
-	const auto CreateFeaturedSortKey = [&](not_null<DocumentData*> document) {
-		return CreateSortKey(document, kSlice * 2);
-	};
-	const auto CreateOtherSortKey = [&](not_null<DocumentData*> document) {
-		return CreateSortKey(document, 0);
-	};
-	const auto InstallDateAdjusted = [&](
-			TimeId date,
-			not_null<DocumentData*> document) {
-		return (document->sticker() && document->sticker()->animated)
-			? date
-			: date / 2;
-	};
-	const auto InstallDate = [&](not_null<DocumentData*> document) {
-		Expects(document->sticker() != nullptr);
-
-		const auto sticker = document->sticker();
-		if (sticker->set.type() == mtpc_inputStickerSetID) {
-			const auto setId = sticker->set.c_inputStickerSetID().vid().v;
-			const auto setIt = sets.find(setId);
-			if (setIt != sets.end()) {
-				return InstallDateAdjusted(setIt->second->installDate, document);
-			}
+			base += kSortKeySlice;
 		}
-		return TimeId(0);
+		return TimeId(base + int((document->id ^ seed) % kSortKeySlice));
 	};
 
-	auto recentIt = sets.find(Stickers::CloudRecentSetId);
-	if (recentIt != sets.cend()) {
-		const auto recent = recentIt->second.get();
-		auto i = recent->emoji.constFind(original);
-		if (i != recent->emoji.cend()) {
-			result.reserve(i->size());
-			for (const auto document : *i) {
-				const auto usageDate = [&] {
-					if (recent->dates.empty()) {
-						return TimeId(0);
-					}
-					const auto index = recent->stickers.indexOf(document);
-					if (index < 0) {
-						return TimeId(0);
-					}
-					Assert(index < recent->dates.size());
-					return recent->dates[index];
-				}();
-				const auto date = usageDate
-					? usageDate
-					: InstallDate(document);
-				result.push_back({
-					document,
-					date ? date : CreateRecentSortKey(document) });
-			}
+	const auto i = index.lists.find(original);
+	const auto list = (i != index.lists.end()) ? &i->second : nullptr;
+	if (list) {
+		result.reserve(list->entries.size());
+		for (const auto &entry : list->entries) {
+			result.push_back({
+				entry.document,
+				(entry.randomDate
+					? CreateSortKey(entry.document, entry.date)
+					: entry.date) });
 		}
 	}
-	const auto addList = [&](const Order &order, MTPDstickerSet::Flag skip) {
-		for (const auto setId : order) {
-			auto it = sets.find(setId);
-			if (it == sets.cend() || (it->second->flags & skip)) {
-				continue;
-			}
-			const auto set = it->second.get();
-			if (set->emoji.isEmpty()) {
-				setsToRequest.emplace(set->id, set->access);
-				set->flags |= MTPDstickerSet_ClientFlag::f_not_loaded;
-				continue;
-			}
-			auto i = set->emoji.constFind(original);
-			if (i == set->emoji.cend()) {
-				continue;
-			}
-			const auto my = (set->flags & MTPDstickerSet::Flag::f_installed_date);
-			result.reserve(result.size() + i->size());
-			for (const auto document : *i) {
-				const auto installDate = my ? set->installDate : TimeId(0);
-				const auto date = (installDate > 1)
-					? InstallDateAdjusted(installDate, document)
-					: my
-					? CreateMySortKey(document)
-					: CreateFeaturedSortKey(document);
-				add(document, date);
-			}
-		}
-	};
-
-	addList(
-		session->data().stickerSetsOrder(),
-		MTPDstickerSet::Flag::f_archived);
-	//addList(
-	//	session->data().featuredStickerSetsOrder(),
-	//	MTPDstickerSet::Flag::f_installed_date);
 
-	if (!setsToRequest.empty()) {
-		for (const auto &[setId, accessHash] : setsToRequest) {
+	if (!index.setsToRequest.empty()) {
+		for (const auto &[setId, accessHash] : index.setsToRequest) {
 			session->api().scheduleStickerSetRequest(setId, accessHash);
 		}
 		session->api().requestStickerSets();
@@ -860,9 +906,14 @@ std::vector<not_null<DocumentData*>> GetListByEmoji(
 		if (!others) {
 			return {};
 		}
+		auto added = base::flat_set<not_null<DocumentData*>>();
 		result.reserve(result.size() + others->size());
 		for (const auto document : *others) {
-			add(document, CreateOtherSortKey(document));
+			if ((list && list->documents.contains(document))
+				|| !added.emplace(document).second) {
+				continue;
+			}
+			result.push_back({ document, CreateSortKey(document, 0) });
 		}
 	}
 
@@ -1151,6 +1202,13 @@ auto LottieCachedFromContent(
 	const auto weak = base::make_weak(session.get());
 	const auto put = [=](QByteArray &&cached) {
 		crl::on_main(weak, [=, data = std::move(cached)]() mutable {
+			if (data.size() > kMaxCachedLottieSize) {
+				// Remember it between launches, so that we don't
+				// encode the frames for the cache again.
+				weak->settings().setLottieCacheOversized(key.high, key.low);
+				weak->saveSettingsDelayed();
+				return;
+			}
 			weak->data().cacheBigFile().put(key, std::move(data));
 		});
 	};
@@ -1170,24 +1228,26 @@ auto LottieFromDocument(
 	const auto document = media->owner();
 	const auto data = media->bytes();
 	const auto filepath = document->filepath();
-	if (box.width() * box.height() > kDontCacheLottieAfterArea) {
-		// Don't use frame caching for large stickers.
+	const auto baseKey = document->bigFileBaseCacheKey();
+	const auto &settings = document->session().settings();
+	const auto oversized = settings.lottieCacheOversized(
+		baseKey.high,
+		baseKey.low + keyShift);
+	if (!baseKey
+		|| oversized
+		|| box.width() * box.height() > kDontCacheLottieAfterArea) {
+		// Don't use frame caching for huge stickers.
 		return method(
 			Lottie::ReadContent(data, filepath),
 			Lottie::FrameRequest{ box });
 	}
-	if (const auto baseKey = document->bigFileBaseCacheKey()) {
-		return LottieCachedFromContent(
-			std::forward<Method>(method),
-			baseKey,
-			keyShift,
-			&document->session(),
-			Lottie::ReadContent(data, filepath),
-			box);
-	}
-	return method(
+	return LottieCachedFromContent(
+		std::forward<Method>(method),
+		baseKey,
+		keyShift,
+		&document->session(),
 		Lottie::ReadContent(data, filepath),
-		Lottie::FrameRequest{ box });
+		box);
 }
 
 std::unique_ptr<Lottie::SinglePlayer> LottiePlayerFromDocument(
@@ -1224,6 +1284,44 @@ std::unique_ptr<Lottie::SinglePlayer> LottiePlayerFromDocument(
 	return LottieFromDocument(method, media, uint8(keyShift), box);
 }
 
+std::shared_ptr<Lottie::SinglePlayer> LottieSharedPlayerFromDocument(
+		not_null<Data::DocumentMedia*> media,
+		const Lottie::ColorReplacements *replacements,
+		LottieSize sizeTag,
+		QSize box,
+		Lottie::Quality quality) {
+	const auto key = SharedPlayerKey{
+		media->owner(),
+		replacements ? replacements->tag : uint8(0),
+		sizeTag,
+		box.width(),
+		box.height(),
+		quality
+	};
+	auto &weak = SharedPlayers[key];
+	if (auto result = weak.lock()) {
+		return result;
+	}
+	auto result = std::shared_ptr<Lottie::SinglePlayer>(
+		LottiePlayerFromDocument(
+			media,
+			replacements,
+			sizeTag,
+			box,
+			quality));
+	weak = result;
+
+	// Players die together with their views, drop the expired entries.
+	for (auto i = SharedPlayers.begin(); i != SharedPlayers.end();) {
+		if (i->second.expired()) {
+			i = SharedPlayers.erase(i);
+		} else {
+			++i;
+		}
+	}
+	return result;
+}
+
 not_null<Lottie::Animation*> LottieAnimationFromDocument(
 		not_null<Lottie::MultiPlayer*> player,
 		not_null<Data::DocumentMedia*> media,
@@ -1235,6 +1333,15 @@ not_null<Lottie::Animation*> LottieAnimationFromDocument(
 	return LottieFromDocument(method, media, uint8(sizeTag), box);
 }
 
+std::shared_ptr<Lottie::FrameRenderer> PanelsLottieRenderer() {
+	if (auto result = PanelsRenderer.lock()) {
+		return result;
+	}
+	auto result = Lottie::MakeFrameRenderer();
+	PanelsRenderer = result;
+	return result;
+}
+
 bool HasLottieThumbnail(
 		SetThumbnailView *thumb,
 		Data::DocumentMedia *media) {
@@ -91,6 +91,7 @@ enum class LottieSize : uchar {
 	StickersFooter,
 	SetsListThumbnail,
 	InlineResults,
+	MediaPreview,
 };
 
 [[nodiscard]] std::unique_ptr<Lottie::SinglePlayer> LottiePlayerFromDocument(
@@ -106,12 +107,27 @@ enum class LottieSize : uchar {
 	QSize box,
 	Lottie::Quality quality = Lottie::Quality(),
 	std::shared_ptr<Lottie::FrameRenderer> renderer = nullptr);
+
+// Views showing the same animated sticker with the same size and colors
+// share one player, so each frame is rendered once for all of them.
+// Use it only for looping views: the frame advances when any one of
+// them marks it shown.
+[[nodiscard]] std::shared_ptr<Lottie::SinglePlayer> LottieSharedPlayerFromDocument(
+	not_null<Data::DocumentMedia*> media,
+	const Lottie::ColorReplacements *replacements,
+	LottieSize sizeTag,
+	QSize box,
+	Lottie::Quality quality = Lottie::Quality());
 [[nodiscard]] not_null<Lottie::Animation*> LottieAnimationFromDocument(
 	not_null<Lottie::MultiPlayer*> player,
 	not_null<Data::DocumentMedia*> media,
 	LottieSize sizeTag,
 	QSize box);
 
+// All sticker panels render their animations on one shared renderer,
+// so together they are limited by the same frame budget.
+[[nodiscard]] std::shared_ptr<Lottie::FrameRenderer> PanelsLottieRenderer();
+
 [[nodiscard]] bool HasLottieThumbnail(
 	SetThumbnailView *thumb,
 	Data::DocumentMedia *media);
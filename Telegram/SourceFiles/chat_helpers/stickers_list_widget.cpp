@@ -1656,6 +1656,9 @@ void StickersListWidget::checkVisibleLottie() {
 		if (destroyBelow <= info.rowsTop
 			|| destroyAbove >= info.rowsBottom) {
 			clearHeavyIn(shownSets()[info.section]);
+		} else if (visibleTop >= info.rowsBottom
+			|| visibleBottom <= info.rowsTop) {
+			pauseAllLottieIn(shownSets()[info.section]);
 		} else if ((visibleTop > info.rowsTop && visibleTop < info.rowsBottom)
 			|| (visibleBottom > info.rowsTop
 				&& visibleBottom < info.rowsBottom)) {
@@ -1665,6 +1668,18 @@ void StickersListWidget::checkVisibleLottie() {
 	});
 }
 
+void StickersListWidget::pauseAllLottieIn(Set &set) {
+	const auto player = set.lottiePlayer.get();
+	if (!player) {
+		return;
+	}
+	for (const auto &sticker : set.stickers) {
+		if (const auto animated = sticker.animated) {
+			player->pause(animated);
+		}
+	}
+}
+
 void StickersListWidget::clearHeavyIn(Set &set, bool clearSavedFrames) {
 	const auto player = base::take(set.lottiePlayer);
 	const auto lifetime = base::take(set.lottieLifetime);
@@ -2808,12 +2823,7 @@ void StickersListWidget::showPreview() {
 
 auto StickersListWidget::getLottieRenderer()
 -> std::shared_ptr<Lottie::FrameRenderer> {
-	if (auto result = _lottieRenderer.lock()) {
-		return result;
-	}
-	auto result = Lottie::MakeFrameRenderer();
-	_lottieRenderer = result;
-	return result;
+	return Stickers::PanelsLottieRenderer();
 }
 
 void StickersListWidget::showStickerSet(uint64 setId) {
@@ -3007,7 +3017,7 @@ void StickersListWidget::removeSet(uint64 setId) {
 		auto text = tr::lng_stickers_remove_pack(tr::now, lt_sticker_pack, set->title);
 		Ui::show(Box<ConfirmBox>(text, tr::lng_stickers_remove_pack_confirm(tr::now), crl::guard(this, [=] {
 			Ui::hideLayer();
-			const auto &sets = session().data().stickerSets();
+			auto &sets = session().data().stickerSetsRef();
 			const auto it = sets.find(_removingSetId);
 			if (it != sets.cend()) {
 				const auto set = it->second.get();
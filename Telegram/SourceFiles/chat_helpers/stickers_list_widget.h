@@ -266,6 +266,7 @@ private:
 	void markLottieFrameShown(Set &set);
 	void checkVisibleLottie();
 	void pauseInvisibleLottieIn(const SectionInfo &info);
+	void pauseAllLottieIn(Set &set);
 	void takeHeavyData(std::vector<Set> &to, std::vector<Set> &from);
 	void takeHeavyData(Set &to, Set &from);
 	void takeHeavyData(Sticker &to, Sticker &from);
@@ -322,7 +323,6 @@ private:
 	base::flat_set<uint64> _installedLocallySets;
 	std::vector<bool> _custom;
 	base::flat_set<not_null<DocumentData*>> _favedStickersMap;
-	std::weak_ptr<Lottie::FrameRenderer> _lottieRenderer;
 
 	mtpRequestId _officialRequestId = 0;
 	int _officialOffset = 0;
@@ -29,6 +29,22 @@ using ByEmojiMap = QMap<EmojiPtr, Pack>;
 class Set;
 using Sets = base::flat_map<uint64, std::unique_ptr<Set>>;
 
+// Stickers of the recent and installed sets grouped by emoji.
+// Built by GetListByEmoji() and kept until the sets are changed.
+struct EmojiIndex {
+	struct Entry {
+		not_null<DocumentData*> document;
+		TimeId date = 0;
+		bool randomDate = false; // date is a base for a random sort key.
+	};
+	struct List {
+		std::vector<Entry> entries;
+		base::flat_set<not_null<DocumentData*>> documents;
+	};
+	base::flat_map<EmojiPtr, List> lists;
+	base::flat_map<uint64, uint64> setsToRequest;
+};
+
 class SetThumbnailView final {
 public:
 	explicit SetThumbnailView(not_null<Set*> owner);
@@ -362,6 +362,7 @@ TabbedSelector::TabbedSelector(
 		) | rpl::start_with_next([this](uint64 setId) {
 			_tabsSlider->setActiveSection(
 				static_cast<int>(SelectorTab::Stickers));
+			refreshStickersIfNeeded();
 			stickers()->showStickerSet(setId);
 			_showRequests.fire({});
 		}, lifetime());
@@ -498,6 +499,12 @@ void TabbedSelector::updateRestrictedLabelGeometry() {
 		(height() / 3 - _restrictedLabel->height() / 2));
 }
 
+void TabbedSelector::showEvent(QShowEvent *e) {
+	// Covers every way to show, including the third column section
+	// and the window restored from the tray.
+	refreshStickersIfNeeded();
+}
+
 void TabbedSelector::paintEvent(QPaintEvent *e) {
 	Painter p(this);
 
@@ -576,13 +583,25 @@ int TabbedSelector::marginBottom() const {
 void TabbedSelector::refreshStickers() {
 	if (!full()) {
 		return;
+	} else if (!isVisible()) {
+		// Don't force reading sticker sets from the local storage
+		// until the selector is shown.
+		_refreshStickersOnShow = true;
+		return;
 	}
+	_refreshStickersOnShow = false;
 	stickers()->refreshStickers();
-	if (isHidden() || _currentTabType != SelectorTab::Stickers) {
+	if (_currentTabType != SelectorTab::Stickers) {
 		stickers()->preloadImages();
 	}
 }
 
+void TabbedSelector::refreshStickersIfNeeded() {
+	if (base::take(_refreshStickersOnShow)) {
+		stickers()->refreshStickers();
+	}
+}
+
 bool TabbedSelector::preventAutoHide() const {
 	return full() ? stickers()->preventAutoHide() : false;
 }
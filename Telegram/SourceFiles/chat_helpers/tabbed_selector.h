@@ -108,6 +108,7 @@ public:
 protected:
 	void paintEvent(QPaintEvent *e) override;
 	void resizeEvent(QResizeEvent *e) override;
+	void showEvent(QShowEvent *e) override;
 
 private:
 	class Tab {
@@ -163,6 +164,7 @@ private:
 
 	void showAll();
 	void hideForSliding();
+	void refreshStickersIfNeeded();
 
 	bool hasSectionIcons() const;
 	void setWidgetToScrollArea();
@@ -190,6 +192,7 @@ private:
 	int _roundRadius = 0;
 	int _footerTop = 0;
 	PeerData *_currentPeer = nullptr;
+	bool _refreshStickersOnShow = false;
 
 	class SlideAnimation;
 	std::unique_ptr<SlideAnimation> _slideAnimation;
@@ -1175,7 +1175,7 @@ bool DocumentData::saveFromDataChecked() {
 bool DocumentData::isStickerSetInstalled() const {
 	Expects(sticker() != nullptr);
 
-	const auto &sets = _owner->stickerSets();
+	const auto &sets = _owner->stickerSetsInfo();
 	return sticker()->set.match([&](const MTPDinputStickerSetID &data) {
 		const auto i = sets.find(data.vid().v);
 		return (i != sets.cend())
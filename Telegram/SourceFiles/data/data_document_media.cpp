@@ -9,6 +9,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include "data/data_document.h"
 #include "data/data_session.h"
+#include "data/data_good_thumbnails.h"
 #include "data/data_cloud_themes.h"
 #include "data/data_file_origin.h"
 #include "data/data_auto_download.h"
@@ -385,43 +386,44 @@ void DocumentMedia::GenerateGoodThumbnail(
 		: FileType::Video;
 	auto location = document->location().isEmpty()
 		? nullptr
-		: std::make_unique<FileLocation>(document->location());
+		: std::make_shared<FileLocation>(document->location());
 	if (data.isEmpty() && !location) {
 		document->setGoodThumbnailChecked(false);
 		return;
 	}
-	const auto guard = base::make_weak(&document->owner().session());
-	crl::async([=, location = std::move(location)] {
+	const auto prepare = [=] {
 		const auto filepath = (location && location->accessEnable())
 			? location->name()
 			: QString();
-		auto result = PrepareGoodThumbnail(filepath, data, type);
-		auto bytes = QByteArray();
-		if (!result.isNull()) {
-			auto buffer = QBuffer(&bytes);
+		auto result = Data::GoodThumbnail();
+		result.image = PrepareGoodThumbnail(filepath, data, type);
+		if (!result.image.isNull()) {
+			auto buffer = QBuffer(&result.bytes);
 			const auto format = (type == FileType::AnimatedSticker)
 				? "WEBP"
-				: (type == FileType::WallPaper && result.hasAlphaChannel())
+				: (type == FileType::WallPaper
+					&& result.image.hasAlphaChannel())
 				? "PNG"
 				: "JPG";
-			result.save(&buffer, format, kGoodThumbQuality);
+			result.image.save(&buffer, format, kGoodThumbQuality);
 		}
 		if (!filepath.isEmpty()) {
 			location->accessDisable();
 		}
-		const auto cache = bytes.isEmpty() ? QByteArray("(failed)") : bytes;
-		crl::on_main(guard, [=] {
-			document->setGoodThumbnailChecked(true);
-			if (const auto active = document->activeMediaView()) {
-				active->setGoodThumbnail(result);
-			}
-			document->owner().cache().put(
-				document->goodThumbnailCacheKey(),
-				Storage::Cache::Database::TaggedValue{
-					base::duplicate(cache),
-					kImageCacheTag });
-		});
-	});
+		return result;
+	};
+	const auto done = [=](Data::GoodThumbnail &&result) {
+		document->setGoodThumbnailChecked(true);
+		if (const auto active = document->activeMediaView()) {
+			active->setGoodThumbnail(result.image);
+		}
+		document->owner().goodThumbnails().store(
+			document->goodThumbnailCacheKey(),
+			(result.bytes.isEmpty()
+				? QByteArray("(failed)")
+				: std::move(result.bytes)));
+	};
+	document->owner().goodThumbnails().generate(document, prepare, done);
 }
 
 void DocumentMedia::CheckGoodThumbnail(not_null<DocumentData*> document) {
@@ -463,7 +465,9 @@ void DocumentMedia::ReadOrGenerateThumbnail(
 			});
 		}
 	};
-	document->owner().cache().get(document->goodThumbnailCacheKey(), got);
+	document->owner().goodThumbnails().get(
+		document->goodThumbnailCacheKey(),
+		got);
 }
 
 } // namespace Data
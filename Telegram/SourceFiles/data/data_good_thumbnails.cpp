@@ -0,0 +1,137 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "data/data_good_thumbnails.h"
+
+#include "data/data_session.h"
+#include "data/data_document.h"
+#include "storage/cache/storage_cache_database.h"
+
+namespace Data {
+namespace {
+
+constexpr auto kFlushWritesDelay = crl::time(1000);
+constexpr auto kFlushWritesCount = 32;
+
+[[nodiscard]] int MaxRunning() {
+	return std::max(QThread::idealThreadCount() / 2, 1);
+}
+
+} // namespace
+
+struct GoodThumbnails::Write {
+	Storage::Cache::Key key;
+	QByteArray bytes;
+	bool ifEmpty = false;
+};
+
+GoodThumbnails::GoodThumbnails(not_null<Session*> owner)
+: _owner(owner)
+, _flushTimer([=] { flushWrites(); }) {
+}
+
+GoodThumbnails::~GoodThumbnails() {
+	flushWrites();
+}
+
+void GoodThumbnails::generate(
+		not_null<DocumentData*> document,
+		Fn<GoodThumbnail()> prepare,
+		Fn<void(GoodThumbnail&&)> done) {
+	auto &callbacks = _callbacks[document];
+	callbacks.push_back(std::move(done));
+	if (callbacks.size() > 1) {
+		return;
+	}
+	_queued.push_back({ document, std::move(prepare) });
+	startNext();
+}
+
+void GoodThumbnails::startNext() {
+	while (_running < MaxRunning() && !_queued.empty()) {
+		const auto visible = ranges::find_if(
+			_queued.rbegin(),
+			_queued.rend(),
+			[](const Task &task) {
+				return task.document->activeMediaView() != nullptr;
+			});
+		const auto i = (visible != _queued.rend())
+			? std::prev(visible.base())
+			: std::prev(_queued.end());
+		auto task = std::move(*i);
+		_queued.erase(i);
+
+		++_running;
+		crl::async([=, task = std::move(task)]() mutable {
+			auto result = task.prepare();
+			crl::on_main(this, [
+				=,
+				task = std::move(task),
+				result = std::move(result)
+			]() mutable {
+				finished(std::move(task), std::move(result));
+			});
+		});
+	}
+}
+
+void GoodThumbnails::finished(Task &&task, GoodThumbnail &&result) {
+	--_running;
+	const auto i = _callbacks.find(task.document);
+	Assert(i != _callbacks.end());
+	const auto callbacks = std::move(i->second);
+	_callbacks.erase(i);
+	for (const auto &done : callbacks) {
+		auto copy = result;
+		done(std::move(copy));
+	}
+	startNext();
+}
+
+void GoodThumbnails::store(
+		const Storage::Cache::Key &key,
+		QByteArray bytes,
+		bool ifEmpty) {
+	_writes.push_back({ key, std::move(bytes), ifEmpty });
+	if (_writes.size() >= kFlushWritesCount) {
+		flushWrites();
+	} else if (!_flushTimer.isActive()) {
+		_flushTimer.callOnce(kFlushWritesDelay);
+	}
+}
+
+void GoodThumbnails::get(
+		const Storage::Cache::Key &key,
+		FnMut<void(QByteArray&&)> done) {
+	const auto i = ranges::find(
+		_writes.rbegin(),
+		_writes.rend(),
+		key,
+		&Write::key);
+	if (i != _writes.rend()) {
+		done(base::duplicate(i->bytes));
+		return;
+	}
+	_owner->cache().get(key, std::move(done));
+}
+
+void GoodThumbnails::flushWrites() {
+	_flushTimer.cancel();
+	auto &cache = _owner->cache();
+	for (auto &write : base::take(_writes)) {
+		auto value = Storage::Cache::Database::TaggedValue(
+			std::move(write.bytes),
+			kImageCacheTag);
+		if (write.ifEmpty) {
+			cache.putIfEmpty(write.key, std::move(value));
+		} else {
+			cache.put(write.key, std::move(value));
+		}
+	}
+}
+
+} // namespace Data
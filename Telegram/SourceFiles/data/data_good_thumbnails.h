@@ -0,0 +1,80 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/timer.h"
+#include "base/weak_ptr.h"
+
+class DocumentData;
+
+namespace Storage {
+namespace Cache {
+struct Key;
+} // namespace Cache
+} // namespace Storage
+
+namespace Data {
+
+class Session;
+
+struct GoodThumbnail {
+	QImage image;
+	QByteArray bytes;
+};
+
+// Generates document good thumbnails on a bounded number of background
+// threads. Documents that have an active media view go first, the most
+// recently requested ones before older ones.
+class GoodThumbnails final : public base::has_weak_ptr {
+public:
+	explicit GoodThumbnails(not_null<Session*> owner);
+	~GoodThumbnails();
+
+	// If a thumbnail for this document is already queued or running,
+	// done is called when that one is ready.
+	void generate(
+		not_null<DocumentData*> document,
+		Fn<GoodThumbnail()> prepare,
+		Fn<void(GoodThumbnail&&)> done);
+
+	// Cache writes are collected and sent to the database together.
+	void store(
+		const Storage::Cache::Key &key,
+		QByteArray bytes,
+		bool ifEmpty = false);
+
+	// Writes that are not flushed yet are served from memory.
+	void get(
+		const Storage::Cache::Key &key,
+		FnMut<void(QByteArray&&)> done);
+
+private:
+	struct Task {
+		not_null<DocumentData*> document;
+		Fn<GoodThumbnail()> prepare;
+	};
+	struct Write;
+
+	void startNext();
+	void finished(Task &&task, GoodThumbnail &&result);
+	void flushWrites();
+
+	const not_null<Session*> _owner;
+
+	std::deque<Task> _queued;
+	base::flat_map<
+		not_null<DocumentData*>,
+		std::vector<Fn<void(GoodThumbnail&&)>>> _callbacks;
+	int _running = 0;
+
+	std::vector<Write> _writes;
+	base::Timer _flushTimer;
+
+};
+
+} // namespace Data
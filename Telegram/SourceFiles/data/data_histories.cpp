@@ -22,12 +22,16 @@ namespace Data {
 namespace {
 
 constexpr auto kReadRequestTimeout = 3 * crl::time(1000);
+constexpr auto kMemoryBudgetCheckTimeout = 60 * crl::time(1000);
+constexpr auto kMemoryBudget = int64(256 * 1024 * 1024);
 
 } // namespace
 
 Histories::Histories(not_null<Session*> owner)
 : _owner(owner)
-, _readRequestsTimer([=] { sendReadRequests(); }) {
+, _readRequestsTimer([=] { sendReadRequests(); })
+, _memoryBudgetTimer([=] { checkMemoryBudget(); }) {
+	_memoryBudgetTimer.callEach(kMemoryBudgetCheckTimeout);
 }
 
 Session &Histories::owner() const {
@@ -62,9 +66,65 @@ void Histories::unloadAll() {
 }
 
 void Histories::clearAll() {
+	_shown = nullptr;
+	_lastShownTime.clear();
 	_map.clear();
 }
 
+void Histories::setShown(History *history) {
+	const auto now = crl::now();
+	if (_shown) {
+		_lastShownTime[_shown] = now;
+	}
+	_shown = history;
+	if (_shown) {
+		_lastShownTime[_shown] = now;
+	}
+}
+
+bool Histories::isShown(not_null<History*> history) const {
+	return _shown
+		&& (_shown == history || _shown->migrateFrom() == history);
+}
+
+int64 Histories::memoryUsage() const {
+	auto result = int64(0);
+	for (const auto &[peerId, history] : _map) {
+		result += history->memoryUsage();
+	}
+	return result;
+}
+
+void Histories::checkMemoryBudget() {
+	auto total = int64(0);
+	auto candidates = std::vector<std::pair<crl::time, not_null<History*>>>();
+	for (const auto &[peerId, history] : _map) {
+		const auto usage = history->memoryUsage();
+		total += usage;
+		if (usage > 0 && !isShown(history.get())) {
+			const auto i = _lastShownTime.find(history.get());
+			const auto shown = (i != end(_lastShownTime)) ? i->second : 0;
+			candidates.emplace_back(shown, history.get());
+		}
+	}
+	if (total <= kMemoryBudget) {
+		return;
+	}
+	ranges::sort(candidates, ranges::less(), [](const auto &pair) {
+		return pair.first;
+	});
+	for (const auto &[shown, history] : candidates) {
+		total -= history->memoryUsage();
+		history->unloadItems();
+		total += history->memoryUsage();
+		if (total <= kMemoryBudget) {
+			break;
+		}
+	}
+	DEBUG_LOG(("Histories: memory budget check, now using %1 bytes."
+		).arg(total));
+}
+
 void Histories::readInbox(not_null<History*> history) {
 	DEBUG_LOG(("Reading: readInbox called."));
 	if (history->lastServerMessageKnown()) {
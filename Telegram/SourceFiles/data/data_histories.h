@@ -44,6 +44,12 @@ public:
 	void unloadAll();
 	void clearAll();
 
+	// The shown history is never unloaded, others are unloaded starting
+	// from the least recently shown when over the memory budget.
+	void setShown(History *history);
+	[[nodiscard]] int64 memoryUsage() const;
+	void checkMemoryBudget();
+
 	void readInbox(not_null<History*> history);
 	void readInboxTill(not_null<HistoryItem*> item);
 	void readInboxTill(not_null<History*> history, MsgId tillId);
@@ -105,6 +111,7 @@ private:
 		not_null<History*> history,
 		not_null<State*> state,
 		int id);
+	[[nodiscard]] bool isShown(not_null<History*> history) const;
 	[[nodiscard]] bool postponeHistoryRequest(const State &state) const;
 	[[nodiscard]] bool postponeEntryRequest(const State &state) const;
 	void postponeRequestDialogEntries();
@@ -114,6 +121,9 @@ private:
 	const not_null<Session*> _owner;
 
 	std::unordered_map<PeerId, std::unique_ptr<History>> _map;
+	History *_shown = nullptr;
+	base::flat_map<not_null<History*>, crl::time> _lastShownTime;
+	base::Timer _memoryBudgetTimer;
 	base::flat_map<not_null<History*>, State> _states;
 	base::flat_map<int, not_null<History*>> _historyByRequest;
 	int _requestAutoincrement = 0;
@@ -0,0 +1,126 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "data/data_messages_map.h"
+
+namespace Data {
+namespace {
+
+constexpr auto kMinCapacity = 16;
+
+// Grow when more than 3/4 of the slots are used.
+[[nodiscard]] bool Overloaded(int size, int capacity) {
+	return (size * 4 > capacity * 3);
+}
+
+} // namespace
+
+HistoryItem *MessagesMap::lookup(MsgId id) const {
+	const auto index = indexOf(id);
+	return (index >= 0) ? _slots[index].item : nullptr;
+}
+
+bool MessagesMap::insert(MsgId id, not_null<HistoryItem*> item) {
+	if (_slots.empty() || Overloaded(_size + 1, _slots.size())) {
+		rehash(std::max(int(_slots.size()) * 2, kMinCapacity));
+	}
+	const auto mask = int(_slots.size()) - 1;
+	for (auto index = startIndex(id);; index = (index + 1) & mask) {
+		auto &slot = _slots[index];
+		if (!slot.item) {
+			slot.id = id;
+			slot.item = item;
+			++_size;
+			return true;
+		} else if (slot.id == id) {
+			return false;
+		}
+	}
+}
+
+HistoryItem *MessagesMap::take(MsgId id) {
+	auto index = indexOf(id);
+	if (index < 0) {
+		return nullptr;
+	}
+	const auto result = _slots[index].item;
+
+	// Backward shift deletion keeps probe sequences without tombstones.
+	const auto mask = int(_slots.size()) - 1;
+	auto next = (index + 1) & mask;
+	while (_slots[next].item) {
+		const auto wanted = startIndex(_slots[next].id);
+		const auto distanceNext = (next - wanted) & mask;
+		const auto distanceHole = (index - wanted) & mask;
+		if (distanceHole <= distanceNext) {
+			_slots[index] = _slots[next];
+			index = next;
+		}
+		next = (next + 1) & mask;
+	}
+	_slots[index] = Slot();
+	--_size;
+	return result;
+}
+
+bool MessagesMap::remove(MsgId id) {
+	return (take(id) != nullptr);
+}
+
+int MessagesMap::size() const {
+	return _size;
+}
+
+bool MessagesMap::empty() const {
+	return !_size;
+}
+
+void MessagesMap::clear() {
+	_slots = std::vector<Slot>();
+	_size = 0;
+	_shift = 32;
+}
+
+int MessagesMap::indexOf(MsgId id) const {
+	if (_slots.empty()) {
+		return -1;
+	}
+	const auto mask = int(_slots.size()) - 1;
+	for (auto index = startIndex(id);; index = (index + 1) & mask) {
+		const auto &slot = _slots[index];
+		if (!slot.item) {
+			return -1;
+		} else if (slot.id == id) {
+			return index;
+		}
+	}
+}
+
+int MessagesMap::startIndex(MsgId id) const {
+	// Fibonacci hashing spreads sequential ids over the whole table.
+	return int((uint32(id) * 2654435769U) >> _shift);
+}
+
+void MessagesMap::rehash(int capacity) {
+	Expects(capacity >= kMinCapacity);
+	Expects(!(capacity & (capacity - 1)));
+
+	auto old = std::exchange(_slots, std::vector<Slot>(capacity));
+	_size = 0;
+	_shift = 32;
+	while (capacity > 1) {
+		capacity >>= 1;
+		--_shift;
+	}
+	for (const auto &slot : old) {
+		if (slot.item) {
+			insert(slot.id, slot.item);
+		}
+	}
+}
+
+} // namespace Data
@@ -0,0 +1,48 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "data/data_types.h"
+
+class HistoryItem;
+
+namespace Data {
+
+// Open addressing MsgId -> HistoryItem* map with linear probing.
+// All entries live in one contiguous array, so a lookup touches one or
+// two cache lines instead of following a bucket node chain.
+class MessagesMap final {
+public:
+	[[nodiscard]] HistoryItem *lookup(MsgId id) const;
+
+	// Returns false if there already is an item with such id.
+	bool insert(MsgId id, not_null<HistoryItem*> item);
+	HistoryItem *take(MsgId id);
+	bool remove(MsgId id);
+
+	[[nodiscard]] int size() const;
+	[[nodiscard]] bool empty() const;
+	void clear();
+
+private:
+	struct Slot {
+		MsgId id = 0;
+		HistoryItem *item = nullptr;
+	};
+
+	[[nodiscard]] int indexOf(MsgId id) const;
+	[[nodiscard]] int startIndex(MsgId id) const;
+	void rehash(int capacity);
+
+	std::vector<Slot> _slots;
+	int _size = 0;
+	int _shift = 32;
+
+};
+
+} // namespace Data
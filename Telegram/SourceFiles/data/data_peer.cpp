@@ -15,6 +15,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_session.h"
 #include "data/data_file_origin.h"
 #include "data/data_histories.h"
+#include "data/data_userpics_atlas.h"
 #include "base/unixtime.h"
 #include "base/crc32hash.h"
 #include "lang/lang_keys.h"
@@ -234,7 +235,10 @@ void PeerData::paintUserpic(
 		int y,
 		int size) const {
 	if (const auto userpic = currentUserpic(view)) {
-		p.drawPixmap(x, y, userpic->pixCircled(size, size));
+		auto &atlas = owner().userpicsAtlas();
+		if (!atlas.paintCircled(p, userpic, x, y, size)) {
+			p.drawPixmap(x, y, userpic->pixCircled(size, size));
+		}
 	} else {
 		ensureEmptyUserpic()->paint(p, x, y, x + size + x, size);
 	}
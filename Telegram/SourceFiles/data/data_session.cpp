@@ -43,6 +43,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_document.h"
 #include "data/data_web_page.h"
 #include "data/data_game.h"
+#include "data/data_good_thumbnails.h"
 #include "data/data_poll.h"
 #include "data/data_chat_filters.h"
 #include "data/data_scheduled_messages.h"
@@ -50,6 +51,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_streaming.h"
 #include "data/data_media_rotation.h"
 #include "data/data_histories.h"
+#include "data/data_userpics_atlas.h"
 #include "base/platform/base_platform_info.h"
 #include "base/unixtime.h"
 #include "base/call_delayed.h"
@@ -222,7 +224,9 @@ Session::Session(not_null<Main::Session*> session)
 , _cloudThemes(std::make_unique<CloudThemes>(session))
 , _streaming(std::make_unique<Streaming>(this))
 , _mediaRotation(std::make_unique<MediaRotation>())
-, _histories(std::make_unique<Histories>(this)) {
+, _histories(std::make_unique<Histories>(this))
+, _userpicsAtlas(std::make_unique<UserpicsAtlas>())
+, _goodThumbnails(std::make_unique<GoodThumbnails>(this)) {
 	_cache->open(Local::cacheKey());
 	_bigFileCache->open(Local::cacheBigFileKey());
 
@@ -265,6 +269,7 @@ void Session::clear() {
 	_games.clear();
 	_documents.clear();
 	_photos.clear();
+	_userpicsAtlas->clear();
 }
 
 void Session::keepAlive(std::shared_ptr<PhotoMedia> media) {
@@ -1225,11 +1230,9 @@ rpl::producer<not_null<HistoryItem*>> Session::unreadItemAdded() const {
 
 void Session::changeMessageId(ChannelId channel, MsgId wasId, MsgId nowId) {
 	const auto list = messagesListForInsert(channel);
-	auto i = list->find(wasId);
-	Assert(i != list->end());
-	auto owned = std::move(i->second);
-	list->erase(i);
-	const auto [j, ok] = list->emplace(nowId, std::move(owned));
+	const auto item = list->take(wasId);
+	Assert(item != nullptr);
+	const auto ok = list->insert(nowId, item);
 
 	Ensures(ok);
 }
@@ -1257,6 +1260,10 @@ rpl::producer<Session::IdChange> Session::itemIdChanged() const {
 }
 
 void Session::requestItemRepaint(not_null<const HistoryItem*> item) {
+	if (updatesBatchActive()) {
+		_itemRepaintsDelayed.emplace(item);
+		return;
+	}
 	_itemRepaintRequest.fire_copy(item);
 	enumerateItemViews(item, [&](not_null<const ViewElement*> view) {
 		requestViewRepaint(view);
@@ -1377,6 +1384,40 @@ void Session::sendHistoryChangeNotifications() {
 	}
 }
 
+bool Session::updatesBatchActive() const {
+	return (_updatesBatchDepth > 0);
+}
+
+void Session::delayChatListSortPosition(not_null<Dialogs::Entry*> entry) {
+	Expects(updatesBatchActive());
+
+	_chatListSortPositionsDelayed.emplace(entry);
+}
+
+void Session::delayChatListEntryRepaint(
+		not_null<const Dialogs::Entry*> entry) {
+	Expects(updatesBatchActive());
+
+	_chatListRepaintsDelayed.emplace(entry);
+}
+
+void Session::finishUpdatesBatch() {
+	Expects(_updatesBatchDepth > 0);
+
+	if (--_updatesBatchDepth > 0) {
+		return;
+	}
+	for (const auto entry : base::take(_chatListSortPositionsDelayed)) {
+		entry->updateChatListSortPosition();
+	}
+	for (const auto entry : base::take(_chatListRepaintsDelayed)) {
+		entry->updateChatListEntry();
+	}
+	for (const auto item : base::take(_itemRepaintsDelayed)) {
+		requestItemRepaint(item);
+	}
+}
+
 void Session::registerHeavyViewPart(not_null<ViewElement*> view) {
 	_heavyViewParts.emplace(view);
 }
@@ -1473,6 +1514,7 @@ rpl::producer<not_null<UserData*>> Session::megagroupParticipantAdded(
 }
 
 void Session::notifyStickersUpdated() {
+	invalidateStickersEmojiIndex();
 	_stickersUpdated.fire({});
 }
 
@@ -1481,9 +1523,20 @@ rpl::producer<> Session::stickersUpdated() const {
 }
 
 void Session::notifyRecentStickersUpdated() {
+	invalidateStickersEmojiIndex();
 	_recentStickersUpdated.fire({});
 }
 
+void Session::invalidateStickersEmojiIndex() {
+	_stickersEmojiIndex = nullptr;
+}
+
+void Session::loadStickerSetsContents() const {
+	if (const auto loader = base::take(_stickerSetsContentsLoader)) {
+		loader();
+	}
+}
+
 rpl::producer<> Session::recentStickersUpdated() const {
 	return _recentStickersUpdated.events();
 }
@@ -1834,12 +1887,11 @@ auto Session::messagesListForInsert(ChannelId channelId)
 void Session::registerMessage(not_null<HistoryItem*> item) {
 	const auto list = messagesListForInsert(item->channelId());
 	const auto itemId = item->id;
-	const auto i = list->find(itemId);
-	if (i != list->end()) {
+	if (const auto existing = list->lookup(itemId)) {
 		LOG(("App Error: Trying to re-registerMessage()."));
-		i->second->destroy();
+		existing->destroy();
 	}
-	list->emplace(itemId, item);
+	list->insert(itemId, item);
 }
 
 void Session::processMessagesDeleted(
@@ -1855,10 +1907,10 @@ void Session::processMessagesDeleted(
 
 	auto historiesToCheck = base::flat_set<not_null<History*>>();
 	for (const auto messageId : data) {
-		const auto i = list ? list->find(messageId.v) : Messages::iterator();
-		if (list && i != list->end()) {
-			const auto history = i->second->history();
-			i->second->destroy();
+		const auto item = list ? list->lookup(messageId.v) : nullptr;
+		if (item) {
+			const auto history = item->history();
+			item->destroy();
 			if (!history->chatListMessageKnown()) {
 				historiesToCheck.emplace(history);
 			}
@@ -1886,10 +1938,11 @@ void Session::removeDependencyMessage(not_null<HistoryItem*> item) {
 
 void Session::unregisterMessage(not_null<HistoryItem*> item) {
 	const auto peerId = item->history()->peer->id;
+	_itemRepaintsDelayed.remove(item);
 	_itemRemoved.fire_copy(item);
 	groups().unregisterMessage(item);
 	removeDependencyMessage(item);
-	messagesListForInsert(peerToChannel(peerId))->erase(item->id);
+	messagesListForInsert(peerToChannel(peerId))->remove(item->id);
 }
 
 MsgId Session::nextLocalMessageId() {
@@ -1904,12 +1957,7 @@ HistoryItem *Session::message(ChannelId channelId, MsgId itemId) const {
 	}
 
 	const auto data = messagesList(channelId);
-	if (!data) {
-		return nullptr;
-	}
-
-	const auto i = data->find(itemId);
-	return (i != data->end()) ? i->second.get() : nullptr;
+	return data ? data->lookup(itemId) : nullptr;
 }
 
 HistoryItem *Session::message(
@@ -1922,6 +1970,11 @@ HistoryItem *Session::message(FullMsgId itemId) const {
 	return message(itemId.channel, itemId.msg);
 }
 
+bool Session::canUnloadMessage(not_null<HistoryItem*> item) const {
+	return (_views.find(item) == end(_views))
+		&& (_dependentMessages.find(item) == end(_dependentMessages));
+}
+
 void Session::updateDependentMessages(not_null<HistoryItem*> item) {
 	const auto i = _dependentMessages.find(item);
 	if (i != end(_dependentMessages)) {
@@ -13,6 +13,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "dialogs/dialogs_indexed_list.h"
 #include "dialogs/dialogs_main_list.h"
 #include "data/data_groups.h"
+#include "data/data_messages_map.h"
 #include "data/data_notify_settings.h"
 #include "history/history_location_manager.h"
 #include "base/timer.h"
@@ -63,6 +64,8 @@ class CloudThemes;
 class Streaming;
 class MediaRotation;
 class Histories;
+class UserpicsAtlas;
+class GoodThumbnails;
 class DocumentMedia;
 class PhotoMedia;
 
@@ -106,6 +109,12 @@ public:
 	[[nodiscard]] Histories &histories() const {
 		return *_histories;
 	}
+	[[nodiscard]] UserpicsAtlas &userpicsAtlas() const {
+		return *_userpicsAtlas;
+	}
+	[[nodiscard]] GoodThumbnails &goodThumbnails() const {
+		return *_goodThumbnails;
+	}
 	[[nodiscard]] MsgId nextNonHistoryEntryId() {
 		return ++_nonHistoryEntryId;
 	}
@@ -240,6 +249,17 @@ public:
 	[[nodiscard]] rpl::producer<not_null<History*>> historyChanged() const;
 	void sendHistoryChangeNotifications();
 
+	// While a batch of updates is applied chat list positions, chat list
+	// rows and item repaints are processed once per entry / item when
+	// the outermost batch is finished.
+	[[nodiscard]] auto updatesBatch() {
+		++_updatesBatchDepth;
+		return gsl::finally([=] { finishUpdatesBatch(); });
+	}
+	[[nodiscard]] bool updatesBatchActive() const;
+	void delayChatListSortPosition(not_null<Dialogs::Entry*> entry);
+	void delayChatListEntryRepaint(not_null<const Dialogs::Entry*> entry);
+
 	void registerHeavyViewPart(not_null<ViewElement*> view);
 	void unregisterHeavyViewPart(not_null<ViewElement*> view);
 	void unloadHeavyViewParts(
@@ -317,17 +337,40 @@ public:
 		return _featuredStickerSetsUnreadCount.value();
 	}
 	const Stickers::Sets &stickerSets() const {
+		loadStickerSetsContents();
 		return _stickerSets;
 	}
 	Stickers::Sets &stickerSetsRef() {
+		loadStickerSetsContents();
+		invalidateStickersEmojiIndex();
+		return _stickerSets;
+	}
+
+	// Sets without loading the stickers deferred by the local storage,
+	// only set infos and flags should be used from here.
+	const Stickers::Sets &stickerSetsInfo() const {
+		return _stickerSets;
+	}
+	Stickers::Sets &stickerSetsInfoRef() {
+		invalidateStickersEmojiIndex();
 		return _stickerSets;
 	}
+	void setStickerSetsContentsLoader(Fn<void()> loader) {
+		_stickerSetsContentsLoader = std::move(loader);
+	}
 	const Stickers::Order &stickerSetsOrder() const {
 		return _stickerSetsOrder;
 	}
 	Stickers::Order &stickerSetsOrderRef() {
+		invalidateStickersEmojiIndex();
 		return _stickerSetsOrder;
 	}
+	[[nodiscard]] const Stickers::EmojiIndex *stickersEmojiIndex() const {
+		return _stickersEmojiIndex.get();
+	}
+	void setStickersEmojiIndex(std::unique_ptr<Stickers::EmojiIndex> index) {
+		_stickersEmojiIndex = std::move(index);
+	}
 	const Stickers::Order &featuredStickerSetsOrder() const {
 		return _featuredStickerSetsOrder;
 	}
@@ -411,6 +454,7 @@ public:
 	[[nodiscard]] HistoryItem *message(FullMsgId itemId) const;
 
 	void updateDependentMessages(not_null<HistoryItem*> item);
+	[[nodiscard]] bool canUnloadMessage(not_null<HistoryItem*> item) const;
 	void registerDependentMessage(
 		not_null<HistoryItem*> dependent,
 		not_null<HistoryItem*> dependency);
@@ -703,9 +747,12 @@ public:
 	void clearLocalStorage();
 
 private:
-	using Messages = std::unordered_map<MsgId, not_null<HistoryItem*>>;
+	using Messages = MessagesMap;
 
 	void suggestStartExport();
+	void finishUpdatesBatch();
+	void invalidateStickersEmojiIndex();
+	void loadStickerSetsContents() const;
 
 	void setupContactViewsViewer();
 	void setupChannelLeavingViewer();
@@ -872,6 +919,10 @@ private:
 	rpl::event_stream<not_null<const History*>> _historyCleared;
 	base::flat_set<not_null<History*>> _historiesChanged;
 	rpl::event_stream<not_null<History*>> _historyChanged;
+	int _updatesBatchDepth = 0;
+	base::flat_set<not_null<Dialogs::Entry*>> _chatListSortPositionsDelayed;
+	base::flat_set<not_null<const Dialogs::Entry*>> _chatListRepaintsDelayed;
+	base::flat_set<not_null<const HistoryItem*>> _itemRepaintsDelayed;
 	rpl::event_stream<MegagroupParticipant> _megagroupParticipantRemoved;
 	rpl::event_stream<MegagroupParticipant> _megagroupParticipantAdded;
 	rpl::event_stream<DialogsRowReplacement> _dialogsRowReplacements;
@@ -887,7 +938,9 @@ private:
 	crl::time _lastSavedGifsUpdate = 0;
 	rpl::variable<int> _featuredStickerSetsUnreadCount = 0;
 	Stickers::Sets _stickerSets;
+	mutable Fn<void()> _stickerSetsContentsLoader;
 	Stickers::Order _stickerSetsOrder;
+	std::unique_ptr<Stickers::EmojiIndex> _stickersEmojiIndex;
 	Stickers::Order _featuredStickerSetsOrder;
 	Stickers::Order _archivedStickerSetsOrder;
 	Stickers::SavedGifs _savedGifs;
@@ -898,7 +951,7 @@ private:
 
 	MsgId _localMessageIdCounter = StartClientMsgId;
 	Messages _messages;
-	std::map<ChannelId, Messages> _channelMessages;
+	std::unordered_map<ChannelId, Messages> _channelMessages;
 	std::map<
 		not_null<HistoryItem*>,
 		base::flat_set<not_null<HistoryItem*>>> _dependentMessages;
@@ -1006,6 +1059,8 @@ private:
 	std::unique_ptr<Streaming> _streaming;
 	std::unique_ptr<MediaRotation> _mediaRotation;
 	std::unique_ptr<Histories> _histories;
+	std::unique_ptr<UserpicsAtlas> _userpicsAtlas;
+	std::unique_ptr<GoodThumbnails> _goodThumbnails;
 	MsgId _nonHistoryEntryId = ServerMaxMsgId;
 
 	rpl::lifetime _lifetime;
@@ -0,0 +1,114 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "data/data_userpics_atlas.h"
+
+#include "ui/image/image.h"
+
+namespace Data {
+namespace {
+
+constexpr auto kMaxSlotSize = 256;
+constexpr auto kMaxSheetWidth = 2048;
+constexpr auto kColumns = 16;
+constexpr auto kRows = 8;
+
+} // namespace
+
+struct UserpicsAtlas::Sheet {
+	int pixels = 0;
+	int columns = 0;
+	int rows = 0;
+	QPixmap pixmap;
+	std::vector<qint64> keys;
+	std::vector<uint64> used;
+	base::flat_map<qint64, int> indices;
+
+	[[nodiscard]] QRect rect(int index) const {
+		return QRect(
+			(index % columns) * pixels,
+			(index / columns) * pixels,
+			pixels,
+			pixels);
+	}
+};
+
+UserpicsAtlas::UserpicsAtlas() = default;
+
+UserpicsAtlas::~UserpicsAtlas() = default;
+
+bool UserpicsAtlas::paintCircled(
+		Painter &p,
+		not_null<Image*> image,
+		int x,
+		int y,
+		int size) {
+	const auto factor = cIntRetinaFactor();
+	if (size <= 0 || size * factor > kMaxSlotSize) {
+		return false;
+	}
+	auto &found = sheet(size, factor);
+	const auto index = slot(found, image, size);
+	p.drawPixmap(QRect(x, y, size, size), found.pixmap, found.rect(index));
+	return true;
+}
+
+void UserpicsAtlas::clear() {
+	_sheets.clear();
+}
+
+auto UserpicsAtlas::sheet(int size, int factor) -> Sheet& {
+	const auto key = std::make_pair(size, factor);
+	const auto i = _sheets.find(key);
+	if (i != end(_sheets)) {
+		return *i->second;
+	}
+	auto result = std::make_unique<Sheet>();
+	result->pixels = size * factor;
+	result->columns = std::min(kColumns, kMaxSheetWidth / result->pixels);
+	result->rows = kRows;
+	result->pixmap = QPixmap(
+		result->columns * result->pixels,
+		result->rows * result->pixels);
+	result->pixmap.fill(Qt::transparent);
+	const auto count = result->columns * result->rows;
+	result->keys.resize(count, 0);
+	result->used.resize(count, 0);
+	return *_sheets.emplace(key, std::move(result)).first->second;
+}
+
+int UserpicsAtlas::slot(Sheet &sheet, not_null<Image*> image, int size) {
+	// QImage cache keys are never reused, unlike Image addresses.
+	const auto key = image->original().cacheKey();
+	const auto i = sheet.indices.find(key);
+	if (i != end(sheet.indices)) {
+		sheet.used[i->second] = ++_ticks;
+		return i->second;
+	}
+	const auto oldest = std::min_element(begin(sheet.used), end(sheet.used));
+	const auto index = int(oldest - begin(sheet.used));
+	if (const auto was = sheet.keys[index]) {
+		sheet.indices.remove(was);
+	}
+	sheet.keys[index] = key;
+	sheet.used[index] = ++_ticks;
+	sheet.indices.emplace(key, index);
+
+	const auto prepared = Images::prepare(
+		image->original(),
+		sheet.pixels,
+		sheet.pixels,
+		Images::Option::Smooth | Images::Option::Circled,
+		size,
+		size);
+	QPainter q(&sheet.pixmap);
+	q.setCompositionMode(QPainter::CompositionMode_Source);
+	q.drawImage(sheet.rect(index), prepared);
+	return index;
+}
+
+} // namespace Data
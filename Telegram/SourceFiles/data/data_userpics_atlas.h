@@ -0,0 +1,43 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+class Image;
+class Painter;
+
+namespace Data {
+
+// Circled userpics of list rows share one pixmap per size and scale,
+// rows are painted from its slots reused in least recently used order.
+class UserpicsAtlas final {
+public:
+	UserpicsAtlas();
+	~UserpicsAtlas();
+
+	// Returns false if the userpic is too large to be kept in the atlas.
+	bool paintCircled(
+		Painter &p,
+		not_null<Image*> image,
+		int x,
+		int y,
+		int size);
+
+	void clear();
+
+private:
+	struct Sheet;
+
+	[[nodiscard]] Sheet &sheet(int size, int factor);
+	[[nodiscard]] int slot(Sheet &sheet, not_null<Image*> image, int size);
+
+	base::flat_map<std::pair<int, int>, std::unique_ptr<Sheet>> _sheets;
+	uint64 _ticks = 0;
+
+};
+
+} // namespace Data
@@ -210,6 +210,13 @@ PositionChange Entry::adjustByPosInChatList(
 
 void Entry::setChatListTimeId(TimeId date) {
 	_timeId = date;
+	if (owner().updatesBatchActive()) {
+		owner().delayChatListSortPosition(this);
+		if (const auto folder = this->folder()) {
+			owner().delayChatListSortPosition(folder);
+		}
+		return;
+	}
 	updateChatListSortPosition();
 	if (const auto folder = this->folder()) {
 		folder->updateChatListSortPosition();
@@ -265,6 +272,10 @@ void Entry::addChatListEntryByLetter(
 }
 
 void Entry::updateChatListEntry() const {
+	if (owner().updatesBatchActive()) {
+		owner().delayChatListEntryRepaint(this);
+		return;
+	}
 	if (const auto main = App::main()) {
 		for (const auto &[filterId, links] : _chatListLinks) {
 			main->repaintDialogRow(filterId, links.main);
@@ -12,6 +12,58 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/history.h"
 
 namespace Dialogs {
+namespace {
+
+[[nodiscard]] QStringList NonEmptyWords(const QStringList &words) {
+	auto result = QStringList();
+	result.reserve(words.size());
+	for (const auto &word : words) {
+		if (!word.isEmpty()) {
+			result.push_back(word);
+		}
+	}
+	return result;
+}
+
+[[nodiscard]] bool HasWordWithPrefix(
+		const base::flat_set<QString> &nameWords,
+		const QString &prefix) {
+	// All words starting with prefix follow it directly in sorted order.
+	const auto i = std::lower_bound(
+		nameWords.begin(),
+		nameWords.end(),
+		prefix);
+	return (i != nameWords.end()) && i->startsWith(prefix);
+}
+
+[[nodiscard]] bool HasAllWords(
+		const base::flat_set<QString> &nameWords,
+		const QStringList &words) {
+	for (const auto &word : words) {
+		if (!HasWordWithPrefix(nameWords, word)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Each result for 'now' is also a result for 'was' if every word
+// of 'was' is a prefix of some word of 'now'.
+[[nodiscard]] bool NarrowsSearch(
+		const QStringList &was,
+		const QStringList &now) {
+	for (const auto &word : was) {
+		const auto extended = ranges::any_of(now, [&](const QString &w) {
+			return w.startsWith(word);
+		});
+		if (!extended) {
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace
 
 IndexedList::IndexedList(SortMode sortMode, FilterId filterId)
 : _sortMode(sortMode)
@@ -33,6 +85,7 @@ RowsByLetter IndexedList::addToEnd(Key key) {
 		}
 		result.letters.emplace(ch, j->second.addToEnd(key));
 	}
+	indexNameWords(key);
 	return result;
 }
 
@@ -49,10 +102,12 @@ Row *IndexedList::addByName(Key key) {
 		}
 		j->second.addByName(key);
 	}
+	indexNameWords(key);
 	return result;
 }
 
 void IndexedList::adjustByDate(const RowsByLetter &links) {
+	invalidateFiltered();
 	_list.adjustByDate(links.main);
 	for (const auto [ch, row] : links.letters) {
 		if (auto it = _index.find(ch); it != _index.cend()) {
@@ -63,6 +118,7 @@ void IndexedList::adjustByDate(const RowsByLetter &links) {
 
 void IndexedList::moveToTop(Key key) {
 	if (_list.moveToTop(key)) {
+		invalidateFiltered();
 		for (const auto ch : key.entry()->chatListFirstLetters()) {
 			if (auto it = _index.find(ch); it != _index.cend()) {
 				it->second.moveToTop(key);
@@ -92,6 +148,7 @@ void IndexedList::peerNameChanged(
 	Expects(_sortMode != SortMode::Date);
 
 	if (const auto history = peer->owner().historyLoaded(peer)) {
+		reindexNameWords(history);
 		if (_sortMode == SortMode::Name) {
 			adjustByName(history, oldLetters);
 		} else {
@@ -107,6 +164,7 @@ void IndexedList::peerNameChanged(
 	Expects(_sortMode == SortMode::Date);
 
 	if (const auto history = peer->owner().historyLoaded(peer)) {
+		reindexNameWords(history);
 		adjustNames(filterId, history, oldLetters);
 	}
 }
@@ -188,6 +246,7 @@ void IndexedList::adjustNames(
 
 void IndexedList::del(Key key, Row *replacedBy) {
 	if (_list.del(key, replacedBy)) {
+		unindexNameWords(key);
 		for (const auto ch : key.entry()->chatListFirstLetters()) {
 			if (auto it = _index.find(ch); it != _index.cend()) {
 				it->second.del(key, replacedBy);
@@ -198,55 +257,106 @@ void IndexedList::del(Key key, Row *replacedBy) {
 
 void IndexedList::clear() {
 	_index.clear();
+	_byNameWord.clear();
+	_nameWordsByKey.clear();
+	invalidateFiltered();
 }
 
-std::vector<not_null<Row*>> IndexedList::filtered(
-		const QStringList &words) const {
-	const auto minimal = [&]() -> const Dialogs::List* {
-		if (empty()) {
-			return nullptr;
-		}
-		auto result = (const Dialogs::List*)nullptr;
-		for (const auto &word : words) {
-			if (word.isEmpty()) {
-				continue;
-			}
-			const auto found = filtered(word[0]);
-			if (!found || found->empty()) {
-				return nullptr;
-			} else if (!result || result->size() > found->size()) {
-				result = found;
+void IndexedList::indexNameWords(Key key) {
+	invalidateFiltered();
+
+	const auto &words = key.entry()->chatListNameWords();
+	const auto i = _nameWordsByKey.emplace(key, words);
+	if (!i.second) {
+		return;
+	}
+	for (const auto &word : words) {
+		_byNameWord.emplace(word, key);
+	}
+}
+
+void IndexedList::unindexNameWords(Key key) {
+	invalidateFiltered();
+
+	const auto i = _nameWordsByKey.find(key);
+	if (i == _nameWordsByKey.end()) {
+		return;
+	}
+	for (const auto &word : i->second) {
+		auto [from, till] = _byNameWord.equal_range(word);
+		for (; from != till; ++from) {
+			if (from->second == key) {
+				_byNameWord.erase(from);
+				break;
 			}
 		}
-		return result;
-	}();
-	auto result = std::vector<not_null<Row*>>();
-	if (!minimal || minimal->empty()) {
+	}
+	_nameWordsByKey.erase(i);
+}
+
+void IndexedList::reindexNameWords(Key key) {
+	invalidateFiltered();
+	if (_nameWordsByKey.find(key) != _nameWordsByKey.end()) {
+		unindexNameWords(key);
+		indexNameWords(key);
+	}
+}
+
+void IndexedList::invalidateFiltered() const {
+	_lastFilterWords.clear();
+	_lastFiltered.clear();
+}
+
+std::vector<not_null<Row*>> IndexedList::filtered(
+		const QStringList &words) const {
+	const auto query = NonEmptyWords(words);
+	if (query.isEmpty() || empty()) {
+		return {};
+	} else if (!_lastFilterWords.isEmpty()
+		&& NarrowsSearch(_lastFilterWords, query)) {
+		// The user typed more characters, filter the previous results.
+		auto result = base::take(_lastFiltered);
+		result.erase(ranges::remove_if(result, [&](not_null<Row*> row) {
+			return !HasAllWords(row->entry()->chatListNameWords(), query);
+		}), end(result));
+		_lastFilterWords = query;
+		_lastFiltered = result;
 		return result;
 	}
-	result.reserve(minimal->size());
-	for (const auto row : *minimal) {
-		const auto &nameWords = row->entry()->chatListNameWords();
-		const auto found = [&](const QString &word) {
-			for (const auto &name : nameWords) {
-				if (name.startsWith(word)) {
-					return true;
-				}
-			}
-			return false;
-		};
-		const auto allFound = [&] {
-			for (const auto &word : words) {
-				if (!found(word)) {
-					return false;
-				}
-			}
-			return true;
-		}();
-		if (allFound) {
+	auto result = filteredByIndex(query);
+	_lastFilterWords = query;
+	_lastFiltered = result;
+	return result;
+}
+
+std::vector<not_null<Row*>> IndexedList::filteredByIndex(
+		const QStringList &words) const {
+	Expects(!words.isEmpty());
+
+	// The longest word usually gives the shortest range of candidates.
+	const auto &longest = *ranges::max_element(
+		words,
+		ranges::less(),
+		[](const QString &word) { return word.size(); });
+	const auto list = filtered(longest[0]);
+	if (!list || list->empty()) {
+		return {};
+	}
+	auto result = std::vector<not_null<Row*>>();
+	for (auto i = _byNameWord.lower_bound(longest)
+		; i != _byNameWord.end() && i->first.startsWith(longest)
+		; ++i) {
+		const auto key = i->second;
+		if (!HasAllWords(key.entry()->chatListNameWords(), words)) {
+			continue;
+		} else if (const auto row = list->getRow(key)) {
 			result.push_back(row);
 		}
 	}
+
+	// Keep the order of the letter list, like a full scan would.
+	ranges::sort(result, ranges::less(), &Row::pos);
+	result.erase(ranges::unique(result), end(result));
 	return result;
 }
 
@@ -75,6 +75,12 @@ private:
 	void adjustByName(
 		Key key,
 		const base::flat_set<QChar> &oldChars);
+	void indexNameWords(Key key);
+	void unindexNameWords(Key key);
+	void reindexNameWords(Key key);
+	void invalidateFiltered() const;
+	[[nodiscard]] std::vector<not_null<Row*>> filteredByIndex(
+		const QStringList &words) const;
 	void adjustNames(
 		FilterId filterId,
 		not_null<History*> history,
@@ -85,6 +91,14 @@ private:
 	List _list, _empty;
 	base::flat_map<QChar, List> _index;
 
+	// Sorted name words for prefix range lookups in filtered(words).
+	std::multimap<QString, Key> _byNameWord;
+	std::map<Key, base::flat_set<QString>> _nameWordsByKey;
+
+	// Last filtered(words) result, narrowed while the query only grows.
+	mutable QStringList _lastFilterWords;
+	mutable std::vector<not_null<Row*>> _lastFiltered;
+
 };
 
 } // namespace Dialogs
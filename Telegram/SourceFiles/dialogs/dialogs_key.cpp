@@ -47,4 +47,13 @@ PeerData *Key::peer() const {
 	return nullptr;
 }
 
+size_t Key::hash() const {
+	if (const auto p = base::get_if<not_null<History*>>(&_value)) {
+		return std::hash<const void*>()(p->get());
+	} else if (const auto p = base::get_if<not_null<Folder*>>(&_value)) {
+		return std::hash<const void*>()(p->get());
+	}
+	return 0;
+}
+
 } // namespace Dialogs
@@ -64,6 +64,8 @@ public:
 		return _value;
 	}
 
+	[[nodiscard]] size_t hash() const;
+
 	// Not working :(
 	//friend inline auto value_ordering_helper(const Key &key) {
 	//	return key.value;
@@ -117,3 +119,14 @@ inline bool operator>=(const RowDescriptor &a, const RowDescriptor &b) {
 }
 
 } // namespace Dialogs
+
+namespace std {
+
+template <>
+struct hash<Dialogs::Key> {
+	size_t operator()(const Dialogs::Key &value) const {
+		return value.hash();
+	}
+};
+
+} // namespace std
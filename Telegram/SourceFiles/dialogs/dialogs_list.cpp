@@ -62,21 +62,24 @@ not_null<Row*> List::addByName(Key key) {
 void List::adjustByName(not_null<Row*> row) {
 	Expects(row->pos() >= 0 && row->pos() < _rows.size());
 
+	// All rows except the adjusted one stay sorted, so binary search
+	// for the new place on both sides of it.
 	const auto &name = row->entry()->chatListName();
 	const auto index = row->pos();
 	const auto i = _rows.begin() + index;
-	const auto before = std::find_if(i + 1, _rows.end(), [&](Row *row) {
+	const auto before = std::partition_point(i + 1, _rows.end(), [&](
+			not_null<Row*> row) {
 		const auto &greater = row->entry()->chatListName();
-		return greater.compare(name, Qt::CaseInsensitive) >= 0;
+		return greater.compare(name, Qt::CaseInsensitive) < 0;
 	});
 	if (before != i + 1) {
 		rotate(i, i + 1, before);
-	} else if (i != _rows.begin()) {
-		const auto from = std::make_reverse_iterator(i);
-		const auto after = std::find_if(from, _rows.rend(), [&](Row *row) {
+	} else {
+		const auto after = std::partition_point(_rows.begin(), i, [&](
+				not_null<Row*> row) {
 			const auto &less = row->entry()->chatListName();
 			return less.compare(name, Qt::CaseInsensitive) <= 0;
-		}).base();
+		});
 		if (after != i) {
 			rotate(after, i, i + 1);
 		}
@@ -89,16 +92,17 @@ void List::adjustByDate(not_null<Row*> row) {
 	const auto key = row->sortKey(_filterId);
 	const auto index = row->pos();
 	const auto i = _rows.begin() + index;
-	const auto before = std::find_if(i + 1, _rows.end(), [&](Row *row) {
-		return (row->sortKey(_filterId) <= key);
+	const auto before = std::partition_point(i + 1, _rows.end(), [&](
+			not_null<Row*> row) {
+		return (row->sortKey(_filterId) > key);
 	});
 	if (before != i + 1) {
 		rotate(i, i + 1, before);
 	} else {
-		const auto from = std::make_reverse_iterator(i);
-		const auto after = std::find_if(from, _rows.rend(), [&](Row *row) {
+		const auto after = std::partition_point(_rows.begin(), i, [&](
+				not_null<Row*> row) {
 			return (row->sortKey(_filterId) >= key);
-		}).base();
+		});
 		if (after != i) {
 			rotate(after, i, i + 1);
 		}
@@ -63,6 +63,10 @@ constexpr auto kSetMyActionForMs = 10000;
 constexpr auto kNewBlockEachMessage = 50;
 constexpr auto kSkipCloudDraftsFor = TimeId(3);
 
+// Rough averages including text, entities and media wrappers.
+constexpr auto kItemMemoryEstimate = int64(2048);
+constexpr auto kViewMemoryEstimate = int64(1024);
+
 } // namespace
 
 History::History(not_null<Data::Session*> owner, PeerId peerId)
@@ -673,7 +677,10 @@ void History::destroyMessage(not_null<HistoryItem*> item) {
 
 	owner().unregisterMessage(item);
 	session().notifications().clearFromItem(item);
+	eraseFromMessages(item);
+}
 
+void History::eraseFromMessages(not_null<HistoryItem*> item) {
 	auto hack = std::unique_ptr<HistoryItem>(item.get());
 	const auto i = _messages.find(hack);
 	hack.release();
@@ -3263,6 +3270,67 @@ void History::clear(ClearType type) {
 	owner().sendHistoryChangeNotifications();
 }
 
+int64 History::memoryUsage() const {
+	auto views = int64(0);
+	for (const auto &block : blocks) {
+		views += block->messages.size();
+	}
+	return int64(_messages.size()) * kItemMemoryEstimate
+		+ views * kViewMemoryEstimate;
+}
+
+bool History::canUnloadItem(not_null<HistoryItem*> item) const {
+	const auto raw = item.get();
+	if (raw == _lastMessage.value_or(nullptr)
+		|| raw == _lastServerMessage.value_or(nullptr)
+		|| raw == _chatListMessage.value_or(nullptr)
+		|| raw == _joinedMessage) {
+		return false;
+	} else if (!IsServerMsgId(item->id)
+		|| item->isScheduled()
+		|| item->unread()
+		|| item->isUnreadMention()
+		|| item->groupId() != MessageGroupId()
+		|| item->id == lastKeyboardId
+		|| item->id == peer->pinnedMessageId()
+		|| ranges::contains(_notifications, item)) {
+		return false;
+	} else if (const auto media = item->media()) {
+		if (media->call()) {
+			// Recent calls list keeps pointers to such items.
+			return false;
+		}
+	}
+	return owner().canUnloadMessage(item);
+}
+
+void History::unloadItems() {
+	clear(ClearType::Unload);
+
+	auto remove = std::vector<not_null<HistoryItem*>>();
+	auto hasSharedMedia = false;
+	for (const auto &item : _messages) {
+		if (canUnloadItem(item.get())) {
+			remove.push_back(item.get());
+			if (item->sharedMediaTypes()) {
+				hasSharedMedia = true;
+			}
+		}
+	}
+	if (hasSharedMedia) {
+		// Removing single ids would leave the ranges marked as loaded,
+		// so drop the whole index and let it be requested again.
+		clearSharedMedia();
+	}
+	for (const auto item : remove) {
+		// Unlike destroyMessage() this keeps the unread state
+		// and the chats list entry untouched.
+		owner().unregisterMessage(item);
+		session().notifications().clearFromItem(item);
+		eraseFromMessages(item);
+	}
+}
+
 void History::clearUpTill(MsgId availableMinId) {
 	auto remove = std::vector<not_null<HistoryItem*>>();
 	remove.reserve(_messages.size());
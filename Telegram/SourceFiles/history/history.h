@@ -89,6 +89,14 @@ public:
 	void clear(ClearType type);
 	void clearUpTill(MsgId availableMinId);
 
+	// Estimated memory used by the loaded items and their views.
+	[[nodiscard]] int64 memoryUsage() const;
+
+	// Unloads the views and all items that are not needed for the chats
+	// list entry, pending notifications and the unread state.
+	// They are requested from the server again when needed.
+	void unloadItems();
+
 	void applyGroupAdminChanges(const base::flat_set<UserId> &changes);
 
 	template <typename ...Args>
@@ -262,6 +270,7 @@ public:
 	bool hasNotification() const;
 	void skipNotification();
 	void popNotification(HistoryItem *item);
+	void removeNotification(not_null<HistoryItem*> item);
 
 	bool hasPendingResizedItems() const;
 	void setHasPendingResizedItems();
@@ -436,6 +445,9 @@ private:
 	void removeBlock(not_null<HistoryBlock*> block);
 	void clearSharedMedia();
 
+	[[nodiscard]] bool canUnloadItem(not_null<HistoryItem*> item) const;
+	void eraseFromMessages(not_null<HistoryItem*> item);
+
 	not_null<HistoryItem*> insertItem(std::unique_ptr<HistoryItem> item);
 	not_null<HistoryItem*> addNewItem(
 		not_null<HistoryItem*> item,
@@ -469,7 +481,6 @@ private:
 	void mainViewRemoved(
 		not_null<HistoryBlock*> block,
 		not_null<Element*> view);
-	void removeNotification(not_null<HistoryItem*> item);
 
 	TimeId adjustedChatListTimeId() const override;
 	void changedChatListPinHook() override;
@@ -141,11 +141,10 @@ void Sticker::draw(Painter &p, const QRect &r, bool selected) {
 }
 
 void Sticker::paintLottie(Painter &p, const QRect &r, bool selected) {
+	// The player may be shared with views that are not selected,
+	// so the selection overlay is applied to the frame we get here.
 	auto request = Lottie::FrameRequest();
 	request.box = _size * cIntRetinaFactor();
-	if (selected && !_nextLastDiceFrame) {
-		request.colored = st::msgStickerOverlay->c;
-	}
 	const auto frame = _lottie
 		? _lottie->frameInfo(request)
 		: Lottie::Animation::FrameInfo();
@@ -156,7 +155,7 @@ void Sticker::paintLottie(Painter &p, const QRect &r, bool selected) {
 	const auto &image = _lastDiceFrame.isNull()
 		? frame.image
 		: _lastDiceFrame;
-	const auto prepared = (!_lastDiceFrame.isNull() && selected)
+	const auto prepared = selected
 		? Images::prepareColored(st::msgStickerOverlay->c, image)
 		: image;
 	const auto size = prepared.size() / cIntRetinaFactor();
@@ -276,12 +275,22 @@ void Sticker::setDiceIndex(const QString &emoji, int index) {
 void Sticker::setupLottie() {
 	Expects(_dataMedia != nullptr);
 
-	_lottie = Stickers::LottiePlayerFromDocument(
-		_dataMedia.get(),
-		_replacements,
-		Stickers::LottieSize::MessageHistory,
-		_size * cIntRetinaFactor(),
-		Lottie::Quality::High);
+	const auto shared = (_diceIndex < 0)
+		&& !isEmojiSticker()
+		&& _data->session().settings().loopAnimatedStickers();
+	_lottie = shared
+		? Stickers::LottieSharedPlayerFromDocument(
+			_dataMedia.get(),
+			_replacements,
+			Stickers::LottieSize::MessageHistory,
+			_size * cIntRetinaFactor(),
+			Lottie::Quality::High)
+		: Stickers::LottiePlayerFromDocument(
+			_dataMedia.get(),
+			_replacements,
+			Stickers::LottieSize::MessageHistory,
+			_size * cIntRetinaFactor(),
+			Lottie::Quality::High);
 	_parent->history()->owner().registerHeavyViewPart(_parent);
 
 	_lottie->updates(
@@ -311,6 +320,7 @@ void Sticker::unloadLottie() {
 		_nextLastDiceFrame = false;
 		_lottieOncePlayed = false;
 	}
+	_lifetime.destroy();
 	_lottie = nullptr;
 	_parent->checkHeavyPart();
 }
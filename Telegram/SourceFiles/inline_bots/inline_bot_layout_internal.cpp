@@ -523,8 +523,9 @@ QSize Sticker::getThumbSize() const {
 void Sticker::setupLottie() const {
 	Expects(_dataMedia != nullptr);
 
-	_lottie = Stickers::LottiePlayerFromDocument(
+	_lottie = Stickers::LottieSharedPlayerFromDocument(
 		_dataMedia.get(),
+		nullptr,
 		Stickers::LottieSize::InlineResults,
 		QSize(
 			st::stickerPanSize.width() - st::buttonRadius * 2,
@@ -213,7 +213,7 @@ private:
 	mutable QPixmap _thumb;
 	mutable bool _thumbLoaded = false;
 
-	mutable std::unique_ptr<Lottie::SinglePlayer> _lottie;
+	mutable std::shared_ptr<Lottie::SinglePlayer> _lottie;
 	mutable std::shared_ptr<Data::DocumentMedia> _dataMedia;
 	mutable rpl::lifetime _lifetime;
 
@@ -23,6 +23,7 @@ constexpr auto kLegacyCallsPeerToPeerNobody = 4;
 constexpr auto kVersionTag = -1;
 constexpr auto kVersion = 1;
 constexpr auto kMaxSavedPlaybackPositions = 16;
+constexpr auto kMaxSavedOversizedLottieCaches = 64;
 
 [[nodiscard]] qint32 SerializePlaybackSpeed(float64 speed) {
 	return int(std::round(std::clamp(speed * 4., 2., 8.))) - 2;
@@ -58,6 +59,8 @@ QByteArray Settings::serialize() const {
 	}
 	size += _variables.groupStickersSectionHidden.size() * sizeof(quint64);
 	size += _variables.mediaLastPlaybackPosition.size() * 2 * sizeof(quint64);
+	size += sizeof(qint32)
+		+ _variables.oversizedLottieCaches.size() * 2 * sizeof(quint64);
 	size += Serialize::bytearraySize(autoDownload);
 	size += Serialize::bytearraySize(_variables.videoPipGeometry);
 
@@ -123,6 +126,10 @@ QByteArray Settings::serialize() const {
 			stream << quint64(i);
 		}
 		stream << qint32(_variables.autoDownloadDictionaries.current() ? 1 : 0);
+		stream << qint32(_variables.oversizedLottieCaches.size());
+		for (const auto &[high, low] : _variables.oversizedLottieCaches) {
+			stream << quint64(high) << quint64(low);
+		}
 	}
 	return result;
 }
@@ -177,6 +184,7 @@ void Settings::constructFromSerialized(const QByteArray &serialized) {
 	QByteArray videoPipGeometry = _variables.videoPipGeometry;
 	std::vector<int> dictionariesEnabled;
 	qint32 autoDownloadDictionaries = _variables.autoDownloadDictionaries.current() ? 1 : 0;
+	std::vector<std::pair<uint64, uint64>> oversizedLottieCaches;
 
 	stream >> versionTag;
 	if (versionTag == kVersionTag) {
@@ -317,6 +325,17 @@ void Settings::constructFromSerialized(const QByteArray &serialized) {
 	if (!stream.atEnd()) {
 		stream >> autoDownloadDictionaries;
 	}
+	if (!stream.atEnd()) {
+		auto count = qint32(0);
+		stream >> count;
+		if (stream.status() == QDataStream::Ok) {
+			for (auto i = 0; i != count; ++i) {
+				quint64 high, low;
+				stream >> high >> low;
+				oversizedLottieCaches.emplace_back(high, low);
+			}
+		}
+	}
 	if (stream.status() != QDataStream::Ok) {
 		LOG(("App Error: "
 			"Bad data for Main::Settings::constructFromSerialized()"));
@@ -408,6 +427,7 @@ void Settings::constructFromSerialized(const QByteArray &serialized) {
 	_variables.videoPipGeometry = videoPipGeometry;
 	_variables.dictionariesEnabled = std::move(dictionariesEnabled);
 	_variables.autoDownloadDictionaries = (autoDownloadDictionaries == 1);
+	_variables.oversizedLottieCaches = std::move(oversizedLottieCaches);
 }
 
 void Settings::setSupportChatsTimeSlice(int slice) {
@@ -530,6 +550,23 @@ crl::time Settings::mediaLastPlaybackPosition(DocumentId id) const {
 	return (i != _variables.mediaLastPlaybackPosition.end()) ? i->second : 0;
 }
 
+void Settings::setLottieCacheOversized(uint64 keyHigh, uint64 keyLow) {
+	if (lottieCacheOversized(keyHigh, keyLow)) {
+		return;
+	}
+	auto &list = _variables.oversizedLottieCaches;
+	if (list.size() >= kMaxSavedOversizedLottieCaches) {
+		list.erase(list.begin());
+	}
+	list.emplace_back(keyHigh, keyLow);
+}
+
+bool Settings::lottieCacheOversized(uint64 keyHigh, uint64 keyLow) const {
+	return ranges::contains(
+		_variables.oversizedLottieCaches,
+		std::make_pair(keyHigh, keyLow));
+}
+
 void Settings::setArchiveCollapsed(bool collapsed) {
 	_variables.archiveCollapsed = collapsed;
 }
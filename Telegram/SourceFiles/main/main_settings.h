@@ -156,6 +156,11 @@ public:
 	void setMediaLastPlaybackPosition(DocumentId id, crl::time time);
 	[[nodiscard]] crl::time mediaLastPlaybackPosition(DocumentId id) const;
 
+	void setLottieCacheOversized(uint64 keyHigh, uint64 keyLow);
+	[[nodiscard]] bool lottieCacheOversized(
+		uint64 keyHigh,
+		uint64 keyLow) const;
+
 	[[nodiscard]] Data::AutoDownload::Full &autoDownload() {
 		return _variables.autoDownload;
 	}
@@ -321,6 +326,7 @@ private:
 		bool suggestStickersByEmoji = true;
 		rpl::variable<bool> spellcheckerEnabled = true;
 		std::vector<std::pair<DocumentId, crl::time>> mediaLastPlaybackPosition;
+		std::vector<std::pair<uint64, uint64>> oversizedLottieCaches;
 		rpl::variable<float64> videoPlaybackSpeed = 1.;
 		QByteArray videoPipGeometry;
 		rpl::variable<std::vector<int>> dictionariesEnabled;
@@ -126,8 +126,11 @@ constexpr auto kNoUpdatesAfterSleepTimeout = 60 * crl::time(1000);
 // Send channel views each second.
 constexpr auto kSendViewsTimeout = crl::time(1000);
 
-// Cache background scaled image after 3s.
-constexpr auto kCacheBackgroundTimeout = 3000;
+// Cache background scaled image after 300ms, it is prepared async.
+constexpr auto kCacheBackgroundTimeout = 300;
+
+// Keep scaled backgrounds for a few last sizes of the chat area.
+constexpr auto kCachedBackgroundsCount = 3;
 
 enum class DataIsLoadedResult {
 	NotLoaded = 0,
@@ -947,43 +950,78 @@ void MainWidget::removeDialog(Dialogs::Key key) {
 void MainWidget::cacheBackground() {
 	if (Window::Theme::Background()->colorForFill()) {
 		return;
-	} else if (Window::Theme::Background()->tile()) {
-		auto &bg = Window::Theme::Background()->pixmapForTiled();
-
-		auto result = QImage(_willCacheFor.width() * cIntRetinaFactor(), _willCacheFor.height() * cIntRetinaFactor(), QImage::Format_RGB32);
-		result.setDevicePixelRatio(cRetinaFactor());
-		{
-			QPainter p(&result);
-			auto left = 0;
-			auto top = 0;
-			auto right = _willCacheFor.width();
-			auto bottom = _willCacheFor.height();
-			auto w = bg.width() / cRetinaFactor();
-			auto h = bg.height() / cRetinaFactor();
-			auto sx = 0;
-			auto sy = 0;
-			auto cx = qCeil(_willCacheFor.width() / w);
-			auto cy = qCeil(_willCacheFor.height() / h);
-			for (int i = sx; i < cx; ++i) {
-				for (int j = sy; j < cy; ++j) {
-					p.drawPixmap(QPointF(i * w, j * h), bg);
+	}
+	const auto forRect = _willCacheFor;
+	const auto generation = _cachedBackgroundsGeneration;
+	_cachingBackgroundFor = forRect;
+	const auto ready = crl::guard(this, [=](QImage result, QRect to) {
+		if (generation != _cachedBackgroundsGeneration) {
+			return;
+		}
+		auto pixmap = App::pixmapFromImageInPlace(std::move(result));
+		pixmap.setDevicePixelRatio(cRetinaFactor());
+		backgroundCached(forRect, std::move(pixmap), to);
+	});
+	if (Window::Theme::Background()->tile()) {
+		const auto &bg = Window::Theme::Background()->pixmapForTiled();
+		const auto ratio = cRetinaFactor();
+		crl::async([=, image = bg.toImage()] {
+			auto result = QImage(
+				forRect.size() * cIntRetinaFactor(),
+				QImage::Format_RGB32);
+			result.setDevicePixelRatio(ratio);
+			{
+				QPainter p(&result);
+				const auto w = image.width() / ratio;
+				const auto h = image.height() / ratio;
+				const auto cx = qCeil(forRect.width() / w);
+				const auto cy = qCeil(forRect.height() / h);
+				for (auto i = 0; i < cx; ++i) {
+					for (auto j = 0; j < cy; ++j) {
+						p.drawImage(QPointF(i * w, j * h), image);
+					}
 				}
 			}
-		}
-		_cachedX = 0;
-		_cachedY = 0;
-		_cachedBackground = App::pixmapFromImageInPlace(std::move(result));
+			crl::on_main([=, result = std::move(result)]() mutable {
+				ready(std::move(result), QRect(QPoint(), forRect.size()));
+			});
+		});
 	} else {
-		auto &bg = Window::Theme::Background()->pixmap();
+		const auto &bg = Window::Theme::Background()->pixmap();
 
 		QRect to, from;
-		Window::Theme::ComputeBackgroundRects(_willCacheFor, bg.size(), to, from);
-		_cachedX = to.x();
-		_cachedY = to.y();
-		_cachedBackground = App::pixmapFromImageInPlace(bg.toImage().copy(from).scaled(to.width() * cIntRetinaFactor(), to.height() * cIntRetinaFactor(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
-		_cachedBackground.setDevicePixelRatio(cRetinaFactor());
+		Window::Theme::ComputeBackgroundRects(forRect, bg.size(), to, from);
+		const auto size = to.size() * cIntRetinaFactor();
+		crl::async([=, image = bg.toImage()] {
+			auto result = image.copy(from).scaled(
+				size,
+				Qt::IgnoreAspectRatio,
+				Qt::SmoothTransformation);
+			crl::on_main([=, result = std::move(result)]() mutable {
+				ready(std::move(result), to);
+			});
+		});
 	}
-	_cachedFor = _willCacheFor;
+}
+
+void MainWidget::backgroundCached(
+		QRect forRect,
+		QPixmap pixmap,
+		QRect to) {
+	if (_cachingBackgroundFor == forRect) {
+		_cachingBackgroundFor = QRect();
+	}
+	_cachedBackgrounds.erase(
+		ranges::remove(
+			_cachedBackgrounds,
+			forRect,
+			&CachedBackground::forRect),
+		end(_cachedBackgrounds));
+	if (_cachedBackgrounds.size() >= kCachedBackgroundsCount) {
+		_cachedBackgrounds.erase(begin(_cachedBackgrounds));
+	}
+	_cachedBackgrounds.push_back({ forRect, std::move(pixmap), to });
+	update();
 }
 
 crl::time MainWidget::highlightStartTime(not_null<const HistoryItem*> item) const {
@@ -1294,22 +1332,55 @@ bool MainWidget::isIdle() const {
 }
 
 void MainWidget::clearCachedBackground() {
-	_cachedBackground = QPixmap();
+	_cachedBackgrounds.clear();
+	++_cachedBackgroundsGeneration;
+	_cachingBackgroundFor = QRect();
 	_cacheBackgroundTimer.cancel();
 	update();
 }
 
-QPixmap MainWidget::cachedBackground(const QRect &forRect, int &x, int &y) {
-	if (!_cachedBackground.isNull() && forRect == _cachedFor) {
-		x = _cachedX;
-		y = _cachedY;
-		return _cachedBackground;
+QPixmap MainWidget::cachedBackground(const QRect &forRect, QRect &to) {
+	const auto exact = ranges::find(
+		_cachedBackgrounds,
+		forRect,
+		&CachedBackground::forRect);
+	if (exact != end(_cachedBackgrounds)) {
+		std::rotate(exact, exact + 1, end(_cachedBackgrounds));
+		to = _cachedBackgrounds.back().to;
+		return _cachedBackgrounds.back().pixmap;
 	}
-	if (_willCacheFor != forRect || !_cacheBackgroundTimer.isActive()) {
+	if (_cachingBackgroundFor != forRect
+		&& (_willCacheFor != forRect || !_cacheBackgroundTimer.isActive())) {
 		_willCacheFor = forRect;
 		_cacheBackgroundTimer.callOnce(kCacheBackgroundTimeout);
 	}
-	return QPixmap();
+
+	// While the exact size is prepared use the nearest one we have.
+	const auto tile = Window::Theme::Background()->tile();
+	const auto distance = [&](const CachedBackground &cached) {
+		return std::abs(cached.forRect.width() - forRect.width())
+			+ std::abs(cached.forRect.height() - forRect.height());
+	};
+	const CachedBackground *nearest = nullptr;
+	for (const auto &cached : _cachedBackgrounds) {
+		if (tile
+			&& (cached.forRect.width() < forRect.width()
+				|| cached.forRect.height() < forRect.height())) {
+			continue;
+		} else if (!nearest || distance(cached) < distance(*nearest)) {
+			nearest = &cached;
+		}
+	}
+	if (!nearest) {
+		return QPixmap();
+	} else if (tile) {
+		to = nearest->to;
+	} else {
+		const auto size = Window::Theme::Background()->pixmap().size();
+		auto from = QRect();
+		Window::Theme::ComputeBackgroundRects(forRect, size, to, from);
+	}
+	return nearest->pixmap;
 }
 
 void MainWidget::updateScrollColors() {
@@ -2901,6 +2972,7 @@ void MainWidget::gotChannelDifference(
 
 void MainWidget::feedChannelDifference(
 		const MTPDupdates_channelDifference &data) {
+	const auto batch = session().data().updatesBatch();
 	session().data().processUsers(data.vusers());
 	session().data().processChats(data.vchats());
 
@@ -3051,6 +3123,7 @@ void MainWidget::feedDifference(
 		const MTPVector<MTPChat> &chats,
 		const MTPVector<MTPMessage> &msgs,
 		const MTPVector<MTPUpdate> &other) {
+	const auto batch = session().data().updatesBatch();
 	session().checkAutoLock();
 	session().data().processUsers(users);
 	session().data().processChats(chats);
@@ -3668,6 +3741,7 @@ void MainWidget::mtpUpdateReceived(const MTPUpdates &updates) {
 }
 
 void MainWidget::feedUpdates(const MTPUpdates &updates, uint64 randomId) {
+	const auto batch = session().data().updatesBatch();
 	switch (updates.type()) {
 	case mtpc_updates: {
 		auto &d = updates.c_updates();
@@ -219,7 +219,7 @@ public:
 
 	bool isIdle() const;
 
-	QPixmap cachedBackground(const QRect &forRect, int &x, int &y);
+	QPixmap cachedBackground(const QRect &forRect, QRect &to);
 	void updateScrollColors();
 
 	void setChatBackground(
@@ -409,6 +409,7 @@ private:
 	void clearHider(not_null<Window::HistoryHider*> instance);
 
 	void cacheBackground();
+	void backgroundCached(QRect forRect, QPixmap pixmap, QRect to);
 	void clearCachedBackground();
 
 	not_null<Media::Player::FloatDelegate*> floatPlayerDelegate();
@@ -523,10 +524,15 @@ private:
 	crl::time _lastUpdateTime = 0;
 	bool _handlingChannelDifference = false;
 
-	QPixmap _cachedBackground;
-	QRect _cachedFor, _willCacheFor;
-	int _cachedX = 0;
-	int _cachedY = 0;
+	struct CachedBackground {
+		QRect forRect;
+		QPixmap pixmap;
+		QRect to;
+	};
+	std::vector<CachedBackground> _cachedBackgrounds; // Last used at end.
+	int _cachedBackgroundsGeneration = 0;
+	QRect _willCacheFor;
+	QRect _cachingBackgroundFor;
 	base::Timer _cacheBackgroundTimer;
 
 	PhotoData *_deletingPhoto = nullptr;
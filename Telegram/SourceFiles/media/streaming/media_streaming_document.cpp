@@ -14,6 +14,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_document.h"
 #include "data/data_document_media.h"
 #include "data/data_file_origin.h"
+#include "data/data_good_thumbnails.h"
 #include "main/main_session.h"
 #include "storage/file_download.h" // Storage::kMaxFileInMemory.
 #include "styles/style_widgets.h"
@@ -214,44 +215,49 @@ void Document::validateGoodThumbnail() {
 	const auto information = _info.video;
 	const auto key = document->goodThumbnailCacheKey();
 	const auto guard = base::make_weak(&document->session());
-	document->owner().cache().get(key, [=](QByteArray value) {
-		if (!value.isEmpty()) {
-			return;
+	const auto prepare = [=] {
+		auto result = Data::GoodThumbnail();
+		result.image = information.cover;
+		if (information.rotation != 0) {
+			auto transform = QTransform();
+			transform.rotate(information.rotation);
+			result.image = result.image.transformed(transform);
+		}
+		if (result.image.size() != information.size) {
+			result.image = result.image.scaled(
+				information.size,
+				Qt::IgnoreAspectRatio,
+				Qt::SmoothTransformation);
 		}
-		const auto image = [&] {
-			auto result = information.cover;
-			if (information.rotation != 0) {
-				auto transform = QTransform();
-				transform.rotate(information.rotation);
-				result = result.transformed(transform);
-			}
-			if (result.size() != information.size) {
-				result = result.scaled(
-					information.size,
-					Qt::IgnoreAspectRatio,
-					Qt::SmoothTransformation);
-			}
-			return result;
-		}();
-		auto bytes = QByteArray();
 		{
-			auto buffer = QBuffer(&bytes);
-			image.save(&buffer, "JPG", kGoodThumbnailQuality);
+			auto buffer = QBuffer(&result.bytes);
+			result.image.save(&buffer, "JPG", kGoodThumbnailQuality);
 		}
-		const auto length = bytes.size();
+		const auto length = result.bytes.size();
 		if (!length || length > Storage::kMaxFileInMemory) {
 			LOG(("App Error: Bad thumbnail data for saving to cache."));
-			bytes = "(failed)";
+			result.bytes = "(failed)";
+		}
+		return result;
+	};
+	const auto done = [=](Data::GoodThumbnail &&result) {
+		if (const auto active = document->activeMediaView()) {
+			active->setGoodThumbnail(result.image);
+		}
+		document->owner().goodThumbnails().store(
+			key,
+			std::move(result.bytes),
+			true);
+	};
+	document->owner().goodThumbnails().get(key, [=](QByteArray value) {
+		if (!value.isEmpty()) {
+			return;
 		}
 		crl::on_main(guard, [=] {
-			if (const auto active = document->activeMediaView()) {
-				active->setGoodThumbnail(image);
-			}
-			document->owner().cache().putIfEmpty(
-				document->goodThumbnailCacheKey(),
-				Storage::Cache::Database::TaggedValue(
-					base::duplicate(bytes),
-					Data::kImageCacheTag));
+			document->owner().goodThumbnails().generate(
+				document,
+				prepare,
+				done);
 		});
 	});
 }
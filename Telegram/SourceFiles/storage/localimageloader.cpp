@@ -31,11 +31,14 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "app.h"
 
 #include <QtCore/QBuffer>
+#include <QtCore/QSemaphore>
+#include <QtGui/QImageWriter>
 
 namespace {
 
 constexpr auto kThumbnailQuality = 87;
 constexpr auto kThumbnailSize = 320;
+constexpr auto kPhotoSideLimit = 1280;
 constexpr auto kPhotoUploadPartSize = 32 * 1024;
 
 using Storage::ValidateThumbDimensions;
@@ -97,18 +100,50 @@ bool FileThumbnailUploadRequired(const QString &filemime, int32 filesize) {
 			== end(kThumbnailKnownMimes));
 }
 
-PreparedFileThumbnail FinalizeFileThumbnail(
-		PreparedFileThumbnail &&prepared,
+struct ImageToEncode {
+	QImage image;
+	const char *format = "JPG";
+	int quality = kThumbnailQuality;
+	not_null<QByteArray*> bytes;
+};
+
+void EncodeImage(const ImageToEncode &data) {
+	auto buffer = QBuffer(data.bytes);
+	auto writer = QImageWriter(&buffer, data.format);
+	writer.setQuality(data.quality);
+	writer.write(data.image);
+}
+
+// All photo sizes and thumbnails of one file are encoded in parallel.
+void EncodeImages(const std::vector<ImageToEncode> &list) {
+	if (list.empty()) {
+		return;
+	}
+	QSemaphore semaphore;
+	for (auto i = 1; i != int(list.size()); ++i) {
+		crl::async([&, i] {
+			EncodeImage(list[i]);
+			semaphore.release();
+		});
+	}
+	EncodeImage(list.front());
+	semaphore.acquire(int(list.size()) - 1);
+}
+
+void FinalizeFileThumbnail(
+		PreparedFileThumbnail &prepared,
 		const QString &filemime,
 		int32 filesize,
-		bool isSticker) {
+		bool isSticker,
+		std::vector<ImageToEncode> &encode) {
 	prepared.name = isSticker ? qsl("thumb.webp") : qsl("thumb.jpg");
 	if (FileThumbnailUploadRequired(filemime, filesize)) {
-		const auto format = QByteArray(isSticker ? "WEBP" : "JPG");
-		auto buffer = QBuffer(&prepared.bytes);
-		prepared.image.save(&buffer, format, kThumbnailQuality);
+		encode.push_back({
+			prepared.image,
+			isSticker ? "WEBP" : "JPG",
+			kThumbnailQuality,
+			&prepared.bytes });
 	}
-	return std::move(prepared);
 }
 
 auto FindAlbumItem(
@@ -244,7 +279,8 @@ SendMediaReady PreparePeerPhoto(PeerId peerId, QImage &&image) {
 		0);
 }
 
-TaskQueue::TaskQueue(crl::time stopTimeoutMs) {
+TaskQueue::TaskQueue(crl::time stopTimeoutMs, int threads)
+: _threadsCount(std::max(threads, 1)) {
 	if (stopTimeoutMs > 0) {
 		_stopTimer = new QTimer(this);
 		connect(_stopTimer, SIGNAL(timeout()), this, SLOT(stop()));
@@ -260,7 +296,7 @@ TaskId TaskQueue::addTask(std::unique_ptr<Task> &&task) {
 		_tasksToProcess.push_back(std::move(task));
 	}
 
-	wakeThread();
+	wakeThreads();
 
 	return result;
 }
@@ -273,78 +309,99 @@ void TaskQueue::addTasks(std::vector<std::unique_ptr<Task>> &&tasks) {
 		}
 	}
 
-	wakeThread();
+	wakeThreads();
 }
 
-void TaskQueue::wakeThread() {
-	if (!_thread) {
-		_thread = new QThread();
+void TaskQueue::wakeThreads() {
+	if (_threads.empty()) {
+		for (auto i = 0; i != _threadsCount; ++i) {
+			const auto thread = new QThread();
+			const auto worker = new TaskQueueWorker(this);
+			worker->moveToThread(thread);
 
-		_worker = new TaskQueueWorker(this);
-		_worker->moveToThread(_thread);
+			connect(this, SIGNAL(taskAdded()), worker, SLOT(onTaskAdded()));
+			connect(worker, SIGNAL(taskProcessed()), this, SLOT(onTaskProcessed()));
 
-		connect(this, SIGNAL(taskAdded()), _worker, SLOT(onTaskAdded()));
-		connect(_worker, SIGNAL(taskProcessed()), this, SLOT(onTaskProcessed()));
-
-		_thread->start();
+			thread->start();
+			_threads.push_back(thread);
+			_workers.push_back(worker);
+		}
 	}
 	if (_stopTimer) _stopTimer->stop();
 	emit taskAdded();
 }
 
 void TaskQueue::cancelTask(TaskId id) {
-	const auto removeFrom = [&](std::deque<std::unique_ptr<Task>> &queue) {
-		const auto proj = [](const std::unique_ptr<Task> &task) {
-			return task->id();
-		};
-		auto i = ranges::find(queue, id, proj);
-		if (i != queue.end()) {
-			queue.erase(i);
-		}
+	const auto proj = [](const std::unique_ptr<Task> &task) {
+		return task->id();
 	};
+	auto nextCanBeFinished = false;
 	{
 		QMutexLocker lock(&_tasksToProcessMutex);
-		removeFrom(_tasksToProcess);
-		if (_taskInProcessId == id) {
-			_taskInProcessId = TaskId();
+		const auto i = ranges::find(_tasksToProcess, id, proj);
+		if (i != _tasksToProcess.end()) {
+			_tasksToProcess.erase(i);
 		}
+		const auto j = ranges::find(_tasksInProcess, id);
+		if (j != _tasksInProcess.end()) {
+			nextCanBeFinished = (j == _tasksInProcess.begin());
+			_tasksInProcess.erase(j);
+		}
+		QMutexLocker lockToFinish(&_tasksToFinishMutex);
+		_tasksToFinish.remove(id);
+	}
+	if (nextCanBeFinished) {
+		// Tasks after the cancelled one may be waiting for it.
+		QMetaObject::invokeMethod(
+			this,
+			"onTaskProcessed",
+			Qt::QueuedConnection);
 	}
-	QMutexLocker lock(&_tasksToFinishMutex);
-	removeFrom(_tasksToFinish);
 }
 
 void TaskQueue::onTaskProcessed() {
 	do {
 		auto task = std::unique_ptr<Task>();
 		{
-			QMutexLocker lock(&_tasksToFinishMutex);
-			if (_tasksToFinish.empty()) break;
-			task = std::move(_tasksToFinish.front());
-			_tasksToFinish.pop_front();
+			QMutexLocker lock(&_tasksToProcessMutex);
+			if (_tasksInProcess.empty()) break;
+
+			QMutexLocker lockToFinish(&_tasksToFinishMutex);
+			const auto i = _tasksToFinish.find(_tasksInProcess.front());
+			if (i == _tasksToFinish.end()) break;
+			task = std::move(i->second);
+			_tasksToFinish.erase(i);
+			_tasksInProcess.pop_front();
 		}
 		task->finish();
 	} while (true);
 
 	if (_stopTimer) {
 		QMutexLocker lock(&_tasksToProcessMutex);
-		if (_tasksToProcess.empty() && !_taskInProcessId) {
+		if (_tasksToProcess.empty() && _tasksInProcess.empty()) {
 			_stopTimer->start();
 		}
 	}
 }
 
 void TaskQueue::stop() {
-	if (_thread) {
-		_thread->requestInterruption();
-		_thread->quit();
-		DEBUG_LOG(("Waiting for taskThread to finish"));
-		_thread->wait();
-		delete base::take(_worker);
-		delete base::take(_thread);
+	for (const auto thread : _threads) {
+		thread->requestInterruption();
+		thread->quit();
+	}
+	if (!_threads.empty()) {
+		DEBUG_LOG(("Waiting for taskThreads to finish"));
+	}
+	for (const auto thread : base::take(_threads)) {
+		thread->wait();
+		delete thread;
+	}
+	for (const auto worker : base::take(_workers)) {
+		delete worker;
 	}
 	_tasksToProcess.clear();
+	_tasksInProcess.clear();
 	_tasksToFinish.clear();
-	_taskInProcessId = TaskId();
 }
 
 TaskQueue::~TaskQueue() {
@@ -364,7 +421,7 @@ void TaskQueueWorker::onTaskAdded() {
 			if (!_queue->_tasksToProcess.empty()) {
 				task = std::move(_queue->_tasksToProcess.front());
 				_queue->_tasksToProcess.pop_front();
-				_queue->_taskInProcessId = task->id();
+				_queue->_tasksInProcess.push_back(task->id());
 			}
 		}
 
@@ -373,13 +430,14 @@ void TaskQueueWorker::onTaskAdded() {
 			bool emitTaskProcessed = false;
 			{
 				QMutexLocker lockToProcess(&_queue->_tasksToProcessMutex);
-				if (_queue->_taskInProcessId == task->id()) {
-					_queue->_taskInProcessId = TaskId();
-					someTasksLeft = !_queue->_tasksToProcess.empty();
+				someTasksLeft = !_queue->_tasksToProcess.empty();
+				const auto &inProcess = _queue->_tasksInProcess;
+				if (ranges::find(inProcess, task->id()) != inProcess.end()) {
+					// Finish could wait for the earlier tasks.
+					emitTaskProcessed = (inProcess.front() == task->id());
 
 					QMutexLocker lockToFinish(&_queue->_tasksToFinishMutex);
-					emitTaskProcessed = _queue->_tasksToFinish.empty();
-					_queue->_tasksToFinish.push_back(std::move(task));
+					_queue->_tasksToFinish.emplace(task->id(), std::move(task));
 				}
 			}
 			if (emitTaskProcessed) {
@@ -625,24 +683,38 @@ bool FileLoadTask::CheckForImage(
 		const QByteArray &content,
 		std::unique_ptr<FileMediaInformation> &result) {
 	auto animated = false;
-	auto image = [&] {
-		if (filepath.endsWith(qstr(".tgs"), Qt::CaseInsensitive)) {
-			auto image = Lottie::ReadThumbnail(
-				Lottie::ReadContent(content, filepath));
-			if (!image.isNull()) {
-				animated = true;
-				result->filemime = qstr("application/x-tgsticker");
-			}
-			return image;
+	if (filepath.endsWith(qstr(".tgs"), Qt::CaseInsensitive)) {
+		auto image = Lottie::ReadThumbnail(
+			Lottie::ReadContent(content, filepath));
+		if (!image.isNull()) {
+			animated = true;
+			result->filemime = qstr("application/x-tgsticker");
 		}
-		if (!content.isEmpty()) {
-			return App::readImage(content, nullptr, false, &animated);
-		} else if (!filepath.isEmpty()) {
-			return App::readImage(filepath, nullptr, false, &animated);
-		}
-		return QImage();
-	}();
-	return FillImageInformation(std::move(image), animated, result);
+		return FillImageInformation(std::move(image), animated, result);
+	}
+
+	// Nothing needs more than kPhotoSideLimit, decode at that size.
+	const auto boxes = std::vector<int>{ kPhotoSideLimit, kThumbnailSize };
+	auto pyramid = !content.isEmpty()
+		? App::readImagePyramid(content, boxes, nullptr, false, &animated)
+		: !filepath.isEmpty()
+		? App::readImagePyramid(filepath, boxes, nullptr, false, &animated)
+		: App::ImagePyramid();
+	if (pyramid.levels.empty()) {
+		return false;
+	}
+	if (!FillImageInformation(
+			std::move(pyramid.levels[0]),
+			animated,
+			result)) {
+		return false;
+	}
+	const auto image = base::get_if<FileMediaInformation::Image>(
+		&result->media);
+	Assert(image != nullptr);
+	image->thumbnail = std::move(pyramid.levels[1]);
+	image->size = pyramid.original;
+	return true;
 }
 
 bool FileLoadTask::FillImageInformation(
@@ -655,6 +727,7 @@ bool FileLoadTask::FillImageInformation(
 		return false;
 	}
 	auto media = FileMediaInformation::Image();
+	media.size = image.size();
 	media.data = std::move(image);
 	media.animated = animated;
 	result->media = media;
@@ -682,6 +755,13 @@ void FileLoadTask::process() {
 	auto isSticker = false;
 
 	auto fullimage = QImage();
+	auto fullthumbnail = QImage();
+	auto fullsize = QSize();
+	const auto takeImage = [&](FileMediaInformation::Image &image) {
+		fullimage = base::take(image.data);
+		fullthumbnail = base::take(image.thumbnail);
+		fullsize = image.size;
+	};
 	auto info = _filepath.isEmpty() ? QFileInfo() : QFileInfo(_filepath);
 	if (info.exists()) {
 		if (info.isDir()) {
@@ -702,9 +782,10 @@ void FileLoadTask::process() {
 		filemime = _information->filemime;
 		if (auto image = base::get_if<FileMediaInformation::Image>(
 				&_information->media)) {
-			fullimage = base::take(image->data);
+			takeImage(*image);
 			if (!Core::IsMimeSticker(filemime)) {
 				fullimage = Images::prepareOpaque(std::move(fullimage));
+				fullthumbnail = Images::prepareOpaque(std::move(fullthumbnail));
 			}
 			isAnimation = image->animated;
 		}
@@ -717,13 +798,14 @@ void FileLoadTask::process() {
 			if (_information) {
 				if (auto image = base::get_if<FileMediaInformation::Image>(
 						&_information->media)) {
-					fullimage = base::take(image->data);
+					takeImage(*image);
 				}
 			}
 			const auto mimeType = Core::MimeTypeForData(_content);
 			filemime = mimeType.name();
 			if (!Core::IsMimeSticker(filemime)) {
 				fullimage = Images::prepareOpaque(std::move(fullimage));
+				fullthumbnail = Images::prepareOpaque(std::move(fullthumbnail));
 			}
 			if (filemime == "image/jpeg") {
 				filename = filedialogDefaultName(qsl("photo"), qsl(".jpg"), QString(), true);
@@ -742,7 +824,7 @@ void FileLoadTask::process() {
 		if (_information) {
 			if (auto image = base::get_if<FileMediaInformation::Image>(
 					&_information->media)) {
-				fullimage = base::take(image->data);
+				takeImage(*image);
 			}
 		}
 		if (!fullimage.isNull() && fullimage.width() > 0) {
@@ -777,6 +859,7 @@ void FileLoadTask::process() {
 	QVector<MTPPhotoSize> photoSizes;
 	QImage goodThumbnail;
 	QByteArray goodThumbnailBytes;
+	auto encode = std::vector<ImageToEncode>();
 
 	QVector<MTPDocumentAttribute> attributes(1, MTP_documentAttributeFilename(MTP_string(filename)));
 
@@ -811,18 +894,22 @@ void FileLoadTask::process() {
 			attributes.push_back(MTP_documentAttributeVideo(MTP_flags(flags), MTP_int(video->duration), MTP_int(coverWidth), MTP_int(coverHeight)));
 
 			goodThumbnail = video->thumbnail;
-			{
-				QBuffer buffer(&goodThumbnailBytes);
-				goodThumbnail.save(&buffer, "JPG", kThumbnailQuality);
-			}
+			encode.push_back({
+				goodThumbnail,
+				"JPG",
+				kThumbnailQuality,
+				&goodThumbnailBytes });
 
 			thumbnail = PrepareFileThumbnail(std::move(video->thumbnail));
 		} else if (filemime == qstr("application/x-tdesktop-theme")
 			|| filemime == qstr("application/x-tgtheme-tdesktop")) {
 			goodThumbnail = Window::Theme::GeneratePreview(_content, _filepath);
 			if (!goodThumbnail.isNull()) {
-				QBuffer buffer(&goodThumbnailBytes);
-				goodThumbnail.save(&buffer, "JPG", kThumbnailQuality);
+				encode.push_back({
+					goodThumbnail,
+					"JPG",
+					kThumbnailQuality,
+					&goodThumbnailBytes });
 
 				thumbnail = PrepareFileThumbnail(base::duplicate(goodThumbnail));
 			}
@@ -830,7 +917,11 @@ void FileLoadTask::process() {
 	}
 
 	if (!fullimage.isNull() && fullimage.width() > 0 && !isSong && !isVideo && !isVoice) {
-		auto w = fullimage.width(), h = fullimage.height();
+		// The image may be decoded already scaled down, see CheckForImage.
+		if (fullsize.isEmpty()) {
+			fullsize = fullimage.size();
+		}
+		auto w = fullsize.width(), h = fullsize.height();
 		attributes.push_back(MTP_documentAttributeImageSize(MTP_int(w), MTP_int(h)));
 
 		if (ValidateThumbDimensions(w, h)) {
@@ -848,26 +939,30 @@ void FileLoadTask::process() {
 					MTPMaskCoords()));
 				if (isAnimation) {
 					goodThumbnail = fullimage;
-					{
-						QBuffer buffer(&goodThumbnailBytes);
-						goodThumbnail.save(&buffer, "WEBP", kThumbnailQuality);
-					}
+					encode.push_back({
+						goodThumbnail,
+						"WEBP",
+						kThumbnailQuality,
+						&goodThumbnailBytes });
 				}
 			} else if (isAnimation) {
 				attributes.push_back(MTP_documentAttributeAnimated());
 			} else if (_type != SendMediaType::File) {
-				auto medium = (w > 320 || h > 320) ? fullimage.scaled(320, 320, Qt::KeepAspectRatio, Qt::SmoothTransformation) : fullimage;
+				auto medium = !fullthumbnail.isNull()
+					? fullthumbnail
+					: (w > 320 || h > 320)
+					? fullimage.scaled(320, 320, Qt::KeepAspectRatio, Qt::SmoothTransformation)
+					: fullimage;
 				photoThumbs.emplace('m', medium);
 				photoSizes.push_back(MTP_photoSize(MTP_string("m"), MTP_fileLocationToBeDeprecated(MTP_long(0), MTP_int(0)), MTP_int(medium.width()), MTP_int(medium.height()), MTP_int(0)));
 
-				auto full = (w > 1280 || h > 1280) ? fullimage.scaled(1280, 1280, Qt::KeepAspectRatio, Qt::SmoothTransformation) : fullimage;
+				auto full = (fullimage.width() > kPhotoSideLimit || fullimage.height() > kPhotoSideLimit)
+					? fullimage.scaled(kPhotoSideLimit, kPhotoSideLimit, Qt::KeepAspectRatio, Qt::SmoothTransformation)
+					: fullimage;
 				photoThumbs.emplace('y', full);
 				photoSizes.push_back(MTP_photoSize(MTP_string("y"), MTP_fileLocationToBeDeprecated(MTP_long(0), MTP_int(0)), MTP_int(full.width()), MTP_int(full.height()), MTP_int(0)));
 
-				{
-					QBuffer buffer(&filedata);
-					full.save(&buffer, "JPG", 87);
-				}
+				encode.push_back({ full, "JPG", 87, &filedata });
 
 				photo = MTP_photo(
 					MTP_flags(0),
@@ -877,19 +972,17 @@ void FileLoadTask::process() {
 					MTP_int(base::unixtime::now()),
 					MTP_vector<MTPPhotoSize>(photoSizes),
 					MTP_int(MTP::maindc()));
-
-				if (filesize < 0) {
-					filesize = _result->filesize = filedata.size();
-				}
 			}
-			thumbnail = PrepareFileThumbnail(std::move(fullimage));
+			thumbnail = PrepareFileThumbnail(fullthumbnail.isNull()
+				? std::move(fullimage)
+				: std::move(fullthumbnail));
 		}
 	}
-	thumbnail = FinalizeFileThumbnail(
-		std::move(thumbnail),
-		filemime,
-		filesize,
-		isSticker);
+	FinalizeFileThumbnail(thumbnail, filemime, filesize, isSticker, encode);
+	EncodeImages(encode);
+	if (filesize < 0) {
+		filesize = _result->filesize = filedata.size();
+	}
 
 	if (_type == SendMediaType::Photo && photo.type() == mtpc_photoEmpty) {
 		_type = SendMediaType::File;
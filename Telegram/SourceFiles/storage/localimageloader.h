@@ -105,7 +105,11 @@ class TaskQueue : public QObject {
 	Q_OBJECT
 
 public:
-	explicit TaskQueue(crl::time stopTimeoutMs = 0); // <= 0 - never stop worker
+	// Tasks are processed on up to threads workers in parallel,
+	// but they are always finished in the order they were added.
+	explicit TaskQueue(
+		crl::time stopTimeoutMs = 0, // <= 0 - never stop workers
+		int threads = 1);
 
 	TaskId addTask(std::unique_ptr<Task> &&task);
 	void addTasks(std::vector<std::unique_ptr<Task>> &&tasks);
@@ -123,14 +127,15 @@ public slots:
 private:
 	friend class TaskQueueWorker;
 
-	void wakeThread();
+	void wakeThreads();
 
 	std::deque<std::unique_ptr<Task>> _tasksToProcess;
-	std::deque<std::unique_ptr<Task>> _tasksToFinish;
-	TaskId _taskInProcessId = TaskId();
+	std::deque<TaskId> _tasksInProcess;
+	base::flat_map<TaskId, std::unique_ptr<Task>> _tasksToFinish;
 	QMutex _tasksToProcessMutex, _tasksToFinishMutex;
-	QThread *_thread = nullptr;
-	TaskQueueWorker *_worker = nullptr;
+	int _threadsCount = 1;
+	std::vector<QThread*> _threads;
+	std::vector<TaskQueueWorker*> _workers;
 	QTimer *_stopTimer = nullptr;
 
 };
@@ -239,6 +244,8 @@ struct FileLoadResult {
 struct FileMediaInformation {
 	struct Image {
 		QImage data;
+		QImage thumbnail;
+		QSize size;
 		bool animated = false;
 	};
 	struct Song {
@@ -18,6 +18,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_document_media.h"
 #include "boxes/send_files_box.h"
 #include "base/flags.h"
+#include "base/crc32hash.h"
 #include "base/platform/base_platform_file_utilities.h"
 #include "base/platform/base_platform_info.h"
 #include "ui/widgets/input_fields.h"
@@ -76,7 +77,8 @@ constexpr auto kSinglePeerTypeSelf = qint32(4);
 constexpr auto kSinglePeerTypeEmpty = qint32(0);
 
 constexpr auto kStickersVersionTag = quint32(-1);
-constexpr auto kStickersSerializeVersion = 1;
+constexpr auto kStickersSerializeVersionInline = 1;
+constexpr auto kStickersSerializeVersion = 2;
 constexpr auto kMaxSavedStickerSetsCount = 1000;
 
 const auto kThemeNewPathRelativeTag = qstr("special://new_tag");
@@ -768,6 +770,25 @@ bool _trustedBotsRead = false;
 
 FileKey _recentStickersKeyOld = 0;
 FileKey _installedStickersKey = 0, _featuredStickersKey = 0, _recentStickersKey = 0, _favedStickersKey = 0, _archivedStickersKey = 0;
+
+struct StickerSetBody {
+	FileKey key = 0;
+	int32 checksum = 0;
+};
+using StickerSetBodies = base::flat_map<uint64, StickerSetBody>;
+
+// Files with stickers of each set, by the key of the sets list file.
+base::flat_map<FileKey, StickerSetBodies> _stickerSetBodies;
+
+struct PendingStickerSetBody {
+	FileKey stickersKey = 0;
+	FileKey key = 0;
+	int32 count = 0;
+};
+
+// Sets read without stickers, their files are read on the first access.
+base::flat_map<uint64, PendingStickerSetBody> _pendingStickerSetBodies;
+
 FileKey _savedGifsKey = 0;
 
 FileKey _backgroundKeyDay = 0;
@@ -2930,6 +2951,8 @@ void reset() {
 	_locationsKey = _trustedBotsKey = 0;
 	_recentStickersKeyOld = 0;
 	_installedStickersKey = _featuredStickersKey = _recentStickersKey = _favedStickersKey = _archivedStickersKey = 0;
+	_stickerSetBodies.clear();
+	_pendingStickerSetBodies.clear();
 	_savedGifsKey = 0;
 	_backgroundKeyDay = _backgroundKeyNight = 0;
 	Window::Theme::Background()->reset();
@@ -3427,44 +3450,170 @@ void cancelTask(TaskId id) {
 	}
 }
 
-void _writeStickerSet(QDataStream &stream, const Stickers::Set &set) {
-	const auto writeInfo = [&](int count) {
-		stream
-			<< quint64(set.id)
-			<< quint64(set.access)
-			<< set.title
-			<< set.shortName
-			<< qint32(count)
-			<< qint32(set.hash)
-			<< qint32(set.flags)
-			<< qint32(set.installDate);
-		Serialize::writeImageLocation(stream, set.thumbnailLocation());
-	};
-	if (set.flags & MTPDstickerSet_ClientFlag::f_not_loaded) {
-		writeInfo(-set.count);
-		return;
-	} else if (set.stickers.isEmpty()) {
+void _clearStickerSetBodies(const FileKey &stickersKey) {
+	for (auto i = begin(_pendingStickerSetBodies); i != end(_pendingStickerSetBodies);) {
+		if (i->second.stickersKey == stickersKey) {
+			i = _pendingStickerSetBodies.erase(i);
+		} else {
+			++i;
+		}
+	}
+
+	const auto i = _stickerSetBodies.find(stickersKey);
+	if (i == end(_stickerSetBodies)) {
 		return;
 	}
+	for (const auto &[setId, body] : i->second) {
+		ClearKey(body.key);
+	}
+	_stickerSetBodies.erase(i);
+}
 
-	writeInfo(set.stickers.size());
-	for (const auto &sticker : set.stickers) {
-		Serialize::Document::writeToStream(stream, sticker);
+quint32 _stickerSetInfoSize(const Stickers::Set &set) {
+	// id + access + title + shortName + stickersCount + hash + flags + installDate
+	auto result = quint32(sizeof(quint64) * 2
+		+ Serialize::stringSize(set.title)
+		+ Serialize::stringSize(set.shortName)
+		+ sizeof(qint32) * 4
+		+ Serialize::imageLocationSize(set.thumbnailLocation()));
+	if (!(set.flags & MTPDstickerSet_ClientFlag::f_not_loaded)) {
+		result += sizeof(quint64) + sizeof(qint32); // bodyKey + checksum
+	}
+	return result;
+}
+
+void _writeStickerSetInfo(
+		QDataStream &stream,
+		const Stickers::Set &set,
+		const StickerSetBody &body) {
+	const auto notLoaded = (set.flags
+		& MTPDstickerSet_ClientFlag::f_not_loaded);
+	stream
+		<< quint64(set.id)
+		<< quint64(set.access)
+		<< set.title
+		<< set.shortName
+		<< qint32(notLoaded ? -set.count : set.stickers.size())
+		<< qint32(set.hash)
+		<< qint32(set.flags)
+		<< qint32(set.installDate);
+	Serialize::writeImageLocation(stream, set.thumbnailLocation());
+	if (!notLoaded) {
+		stream << quint64(body.key) << qint32(body.checksum);
+	}
+}
+
+quint32 _stickerSetBodySize(const Stickers::Set &set) {
+	auto result = quint32(sizeof(qint32)); // stickersCount
+	for (const auto sticker : set.stickers) {
+		result += Serialize::Document::sizeInStream(sticker);
 	}
-	stream << qint32(set.dates.size());
+
+	result += sizeof(qint32); // datesCount
 	if (!set.dates.empty()) {
-		Assert(set.dates.size() == set.stickers.size());
-		for (const auto date : set.dates) {
-			stream << qint32(date);
-		}
+		Assert(set.stickers.size() == set.dates.size());
+		result += set.dates.size() * sizeof(qint32);
 	}
-	stream << qint32(set.emoji.size());
+
+	result += sizeof(qint32); // emojiCount
 	for (auto j = set.emoji.cbegin(), e = set.emoji.cend(); j != e; ++j) {
-		stream << j.key()->id() << qint32(j->size());
+		result += Serialize::stringSize(j.key()->id())
+			+ sizeof(qint32)
+			+ (j->size() * sizeof(quint64));
+	}
+	return result;
+}
+
+// Writes the stickers, dates and emoji packs of the set to its own file,
+// unless the serialized content matches the one already on disk.
+StickerSetBody _writeStickerSetBody(
+		const Stickers::Set &set,
+		StickerSetBody body) {
+	EncryptedDescriptor data(_stickerSetBodySize(set));
+	data.stream << qint32(set.stickers.size());
+	for (const auto &sticker : set.stickers) {
+		Serialize::Document::writeToStream(data.stream, sticker);
+	}
+	data.stream << qint32(set.dates.size());
+	for (const auto date : set.dates) {
+		data.stream << qint32(date);
+	}
+	data.stream << qint32(set.emoji.size());
+	for (auto j = set.emoji.cbegin(), e = set.emoji.cend(); j != e; ++j) {
+		data.stream << j.key()->id() << qint32(j->size());
 		for (const auto sticker : *j) {
-			stream << quint64(sticker->id);
+			data.stream << quint64(sticker->id);
 		}
 	}
+
+	const auto checksum = base::crc32(
+		data.data.constData() + sizeof(uint32),
+		data.data.size() - sizeof(uint32));
+	if (body.key && body.checksum == checksum) {
+		return body;
+	} else if (!body.key) {
+		body.key = GenerateKey();
+	}
+	body.checksum = checksum;
+
+	FileWriteDescriptor file(body.key);
+	file.writeEncrypted(data);
+	return body;
+}
+
+// Collects the set file keys from a sets list file that was not read in
+// this session, so that the files are reused or cleared when it is written.
+void _ensureStickerSetBodies(const FileKey &stickersKey) {
+	if (!stickersKey || _stickerSetBodies.contains(stickersKey)) {
+		return;
+	}
+	auto &bodies = _stickerSetBodies[stickersKey];
+
+	FileReadDescriptor stickers;
+	if (!ReadEncryptedFile(stickers, stickersKey)) {
+		return;
+	}
+	quint32 versionTag = 0;
+	qint32 version = 0;
+	qint32 count = 0;
+	stickers.stream >> versionTag >> version >> count;
+	if (versionTag != kStickersVersionTag
+		|| version != kStickersSerializeVersion
+		|| !_checkStreamStatus(stickers.stream)
+		|| (count < 0)
+		|| (count > kMaxSavedStickerSetsCount)) {
+		// Older lists keep the stickers inline, without separate files.
+		return;
+	}
+	for (auto i = 0; i != count; ++i) {
+		quint64 setId = 0, setAccess = 0;
+		QString setTitle, setShortName;
+		qint32 scnt = 0, setHash = 0, setFlags = 0, setInstallDate = 0;
+		stickers.stream
+			>> setId
+			>> setAccess
+			>> setTitle
+			>> setShortName
+			>> scnt
+			>> setHash
+			>> setFlags
+			>> setInstallDate;
+		const auto thumbnail = Serialize::readImageLocation(
+			stickers.version,
+			stickers.stream);
+		if (!thumbnail || !_checkStreamStatus(stickers.stream)) {
+			return;
+		} else if (scnt < 0) {
+			continue;
+		}
+		quint64 bodyKey = 0;
+		qint32 bodyChecksum = 0;
+		stickers.stream >> bodyKey >> bodyChecksum;
+		if (!_checkStreamStatus(stickers.stream) || !bodyKey) {
+			return;
+		}
+		bodies.emplace(setId, StickerSetBody{ bodyKey, bodyChecksum });
+	}
 }
 
 // In generic method _writeStickerSets() we look through all the sets and call a
@@ -3480,21 +3629,24 @@ template <typename CheckSet>
 void _writeStickerSets(FileKey &stickersKey, CheckSet checkSet, const Stickers::Order &order) {
 	if (!_working()) return;
 
-	const auto &sets = Auth().data().stickerSets();
-	if (sets.empty()) {
+	const auto clear = [&] {
 		if (stickersKey) {
+			_ensureStickerSetBodies(stickersKey);
+			_clearStickerSetBodies(stickersKey);
 			ClearKey(stickersKey);
 			stickersKey = 0;
 			_mapChanged = true;
 		}
 		_writeMap();
-		return;
-	}
+	};
 
-	// versionTag + version + count
-	quint32 size = sizeof(quint32) + sizeof(qint32) + sizeof(qint32);
+	const auto &sets = Auth().data().stickerSets();
+	if (sets.empty()) {
+		return clear();
+	}
 
-	int32 setsCount = 0;
+	auto list = std::vector<not_null<Stickers::Set*>>();
+	list.reserve(sets.size());
 	for (const auto &[id, set] : sets) {
 		const auto raw = set.get();
 		auto result = checkSet(*raw);
@@ -3503,73 +3655,197 @@ void _writeStickerSets(FileKey &stickersKey, CheckSet checkSet, const Stickers::
 		} else if (result == StickerSetCheckResult::Skip) {
 			continue;
 		}
-
-		// id + access + title + shortName + stickersCount + hash + flags + installDate
-		size += sizeof(quint64) * 2
-			+ Serialize::stringSize(raw->title)
-			+ Serialize::stringSize(raw->shortName)
-			+ sizeof(qint32) * 4
-			+ Serialize::imageLocationSize(raw->thumbnailLocation());
-		if (raw->flags & MTPDstickerSet_ClientFlag::f_not_loaded) {
-			continue;
-		}
-
-		for (const auto sticker : raw->stickers) {
-			size += Serialize::Document::sizeInStream(sticker);
-		}
-
-		size += sizeof(qint32); // datesCount
-		if (!raw->dates.empty()) {
-			Assert(raw->stickers.size() == raw->dates.size());
-			size += raw->dates.size() * sizeof(qint32);
-		}
-
-		size += sizeof(qint32); // emojiCount
-		for (auto j = raw->emoji.cbegin(), e = raw->emoji.cend(); j != e; ++j) {
-			size += Serialize::stringSize(j.key()->id()) + sizeof(qint32) + (j->size() * sizeof(quint64));
-		}
-
-		++setsCount;
+		list.push_back(raw);
 	}
-	if (!setsCount && order.isEmpty()) {
-		if (stickersKey) {
-			ClearKey(stickersKey);
-			stickersKey = 0;
-			_mapChanged = true;
-		}
-		_writeMap();
-		return;
+	if (list.empty() && order.isEmpty()) {
+		return clear();
 	}
-	size += sizeof(qint32) + (order.size() * sizeof(quint64));
 
 	if (!stickersKey) {
 		stickersKey = GenerateKey();
 		_mapChanged = true;
 		_writeMap(WriteMapWhen::Fast);
 	}
+
+	// Only the sets that changed since the last write get their files
+	// rewritten, the list file itself holds just the set infos and order.
+	_ensureStickerSetBodies(stickersKey);
+	auto &bodies = _stickerSetBodies[stickersKey];
+	auto written = StickerSetBodies();
+	written.reserve(list.size());
+
+	// versionTag + version + count
+	quint32 size = sizeof(quint32) + sizeof(qint32) + sizeof(qint32);
+	for (const auto set : list) {
+		size += _stickerSetInfoSize(*set);
+		if (set->flags & MTPDstickerSet_ClientFlag::f_not_loaded) {
+			continue;
+		}
+		const auto i = bodies.find(set->id);
+		written.emplace(set->id, _writeStickerSetBody(
+			*set,
+			(i != end(bodies)) ? i->second : StickerSetBody()));
+	}
+	size += sizeof(qint32) + (order.size() * sizeof(quint64));
+
 	EncryptedDescriptor data(size);
 	data.stream
 		<< quint32(kStickersVersionTag)
 		<< qint32(kStickersSerializeVersion)
-		<< qint32(setsCount);
-	for (const auto &[id, set] : sets) {
-		auto result = checkSet(*set);
-		if (result == StickerSetCheckResult::Abort) {
-			return;
-		} else if (result == StickerSetCheckResult::Skip) {
-			continue;
-		}
-		_writeStickerSet(data.stream, *set);
+		<< qint32(list.size());
+	for (const auto set : list) {
+		const auto i = written.find(set->id);
+		_writeStickerSetInfo(
+			data.stream,
+			*set,
+			(i != end(written)) ? i->second : StickerSetBody());
 	}
 	data.stream << order;
 
 	FileWriteDescriptor file(stickersKey);
 	file.writeEncrypted(data);
+
+	for (const auto &[setId, body] : bodies) {
+		if (!written.contains(setId)) {
+			ClearKey(body.key);
+		}
+	}
+	bodies = std::move(written);
 }
 
-void _readStickerSets(FileKey &stickersKey, Stickers::Order *outOrder = nullptr, MTPDstickerSet::Flags readingFlags = 0) {
+bool _readStickerSetBody(
+		QDataStream &stream,
+		int32 streamVersion,
+		not_null<Stickers::Set*> set,
+		int32 scnt,
+		bool fillStickers) {
+	if (fillStickers) {
+		set->stickers.reserve(scnt);
+		set->count = 0;
+	}
+
+	const auto inputSet = MTP_inputStickerSetID(
+		MTP_long(set->id),
+		MTP_long(set->access));
+	Serialize::Document::StickerSetInfo info(
+		set->id,
+		set->access,
+		set->shortName);
+	base::flat_set<DocumentId> read;
+	for (int32 j = 0; j < scnt; ++j) {
+		auto document = Serialize::Document::readStickerFromStream(streamVersion, stream, info);
+		if (!_checkStreamStatus(stream)) {
+			return false;
+		} else if (!document
+			|| !document->sticker()
+			|| read.contains(document->id)) {
+			continue;
+		}
+		read.emplace(document->id);
+		if (fillStickers) {
+			set->stickers.push_back(document);
+			if (!(set->flags & MTPDstickerSet_ClientFlag::f_special)) {
+				if (document->sticker()->set.type() != mtpc_inputStickerSetID) {
+					document->sticker()->set = inputSet;
+				}
+			}
+			++set->count;
+		}
+	}
+
+	qint32 datesCount = 0;
+	stream >> datesCount;
+	if (datesCount > 0) {
+		if (datesCount != scnt) {
+			return false;
+		}
+		const auto fillDates = (set->id == Stickers::CloudRecentSetId)
+			&& (set->stickers.size() == datesCount);
+		if (fillDates) {
+			set->dates.clear();
+			set->dates.reserve(datesCount);
+		}
+		for (auto i = 0; i != datesCount; ++i) {
+			qint32 date = 0;
+			stream >> date;
+			if (fillDates) {
+				set->dates.push_back(TimeId(date));
+			}
+		}
+	}
+
+	qint32 emojiCount = 0;
+	stream >> emojiCount;
+	if (!_checkStreamStatus(stream) || emojiCount < 0) {
+		return false;
+	}
+	for (int32 j = 0; j < emojiCount; ++j) {
+		QString emojiString;
+		qint32 stickersCount;
+		stream >> emojiString >> stickersCount;
+		Stickers::Pack pack;
+		pack.reserve(stickersCount);
+		for (int32 k = 0; k < stickersCount; ++k) {
+			quint64 id;
+			stream >> id;
+			const auto doc = Auth().data().document(id);
+			if (!doc->sticker()) continue;
+
+			pack.push_back(doc);
+		}
+		if (fillStickers) {
+			if (auto emoji = Ui::Emoji::Find(emojiString)) {
+				emoji = emoji->original();
+				set->emoji.insert(emoji, pack);
+			}
+		}
+	}
+	return _checkStreamStatus(stream);
+}
+
+void _readPendingStickerSetBodies() {
+	auto &sets = Auth().data().stickerSetsInfoRef();
+	auto requestSets = false;
+	for (const auto &[setId, pending] : base::take(_pendingStickerSetBodies)) {
+		const auto i = sets.find(setId);
+		if (i == end(sets) || !i->second->stickers.isEmpty()) {
+			continue;
+		}
+		const auto set = i->second.get();
+
+		FileReadDescriptor setBody;
+		if (ReadEncryptedFile(setBody, pending.key)) {
+			qint32 bodyCount = 0;
+			setBody.stream >> bodyCount;
+			if (_checkStreamStatus(setBody.stream)
+				&& bodyCount == pending.count
+				&& _readStickerSetBody(
+					setBody.stream,
+					setBody.version,
+					set,
+					bodyCount,
+					true)) {
+				continue;
+			}
+		}
+
+		// Broken set file, request this set from the server.
+		set->stickers.clear();
+		set->dates.clear();
+		set->emoji.clear();
+		set->flags |= MTPDstickerSet_ClientFlag::f_not_loaded;
+		Auth().api().scheduleStickerSetRequest(set->id, set->access);
+		requestSets = true;
+	}
+	if (requestSets) {
+		Auth().api().requestStickerSets();
+	}
+}
+
+void _readStickerSets(FileKey &stickersKey, Stickers::Order *outOrder = nullptr, MTPDstickerSet::Flags readingFlags = 0, bool deferBodies = false) {
 	FileReadDescriptor stickers;
 	if (!ReadEncryptedFile(stickers, stickersKey)) {
+		_clearStickerSetBodies(stickersKey);
 		ClearKey(stickersKey);
 		stickersKey = 0;
 		_writeMap();
@@ -3577,21 +3853,24 @@ void _readStickerSets(FileKey &stickersKey, Stickers::Order *outOrder = nullptr,
 	}
 
 	const auto failed = [&] {
+		_clearStickerSetBodies(stickersKey);
 		ClearKey(stickersKey);
 		stickersKey = 0;
 	};
 
-	auto &sets = Auth().data().stickerSetsRef();
+	auto &sets = Auth().data().stickerSetsInfoRef();
 	if (outOrder) outOrder->clear();
 
 	quint32 versionTag = 0;
 	qint32 version = 0;
 	stickers.stream >> versionTag >> version;
 	if (versionTag != kStickersVersionTag
-		|| version != kStickersSerializeVersion) {
+		|| (version != kStickersSerializeVersion
+			&& version != kStickersSerializeVersionInline)) {
 		// Old data, without sticker set thumbnails.
 		return failed();
 	}
+	const auto inlineBodies = (version == kStickersSerializeVersionInline);
 	qint32 count = 0;
 	stickers.stream >> count;
 	if (!_checkStreamStatus(stickers.stream)
@@ -3599,6 +3878,7 @@ void _readStickerSets(FileKey &stickersKey, Stickers::Order *outOrder = nullptr,
 		|| (count > kMaxSavedStickerSetsCount)) {
 		return failed();
 	}
+	auto &bodies = _stickerSetBodies[stickersKey];
 	for (auto i = 0; i != count; ++i) {
 		using LocationType = StorageFileLocation::Type;
 
@@ -3634,6 +3914,18 @@ void _readStickerSets(FileKey &stickersKey, Stickers::Order *outOrder = nullptr,
 			setThumbnail = *thumbnail;
 		}
 
+		auto body = StickerSetBody();
+		if (scnt >= 0 && !inlineBodies) {
+			quint64 bodyKey = 0;
+			qint32 bodyChecksum = 0;
+			stickers.stream >> bodyKey >> bodyChecksum;
+			if (!_checkStreamStatus(stickers.stream) || !bodyKey) {
+				return failed();
+			}
+			body = { FileKey(bodyKey), bodyChecksum };
+			bodies.emplace(setId, body);
+		}
+
 		setFlags = MTPDstickerSet::Flags::from_raw(setFlagsValue);
 		if (setId == Stickers::DefaultSetId) {
 			setTitle = tr::lng_stickers_default_set(tr::now);
@@ -3669,7 +3961,6 @@ void _readStickerSets(FileKey &stickersKey, Stickers::Order *outOrder = nullptr,
 				ImageWithLocation{ .location = setThumbnail });
 		}
 		const auto set = it->second.get();
-		auto inputSet = MTP_inputStickerSetID(MTP_long(set->id), MTP_long(set->access));
 		const auto fillStickers = set->stickers.isEmpty();
 
 		if (scnt < 0) { // disabled not loaded set
@@ -3679,80 +3970,42 @@ void _readStickerSets(FileKey &stickersKey, Stickers::Order *outOrder = nullptr,
 			continue;
 		}
 
-		if (fillStickers) {
-			set->stickers.reserve(scnt);
-			set->count = 0;
-		}
-
-		Serialize::Document::StickerSetInfo info(setId, setAccess, setShortName);
-		base::flat_set<DocumentId> read;
-		for (int32 j = 0; j < scnt; ++j) {
-			auto document = Serialize::Document::readStickerFromStream(stickers.version, stickers.stream, info);
-			if (!_checkStreamStatus(stickers.stream)) {
+		if (inlineBodies) {
+			if (!_readStickerSetBody(
+					stickers.stream,
+					stickers.version,
+					set,
+					scnt,
+					fillStickers)) {
 				return failed();
-			} else if (!document
-				|| !document->sticker()
-				|| read.contains(document->id)) {
-				continue;
-			}
-			read.emplace(document->id);
-			if (fillStickers) {
-				set->stickers.push_back(document);
-				if (!(set->flags & MTPDstickerSet_ClientFlag::f_special)) {
-					if (document->sticker()->set.type() != mtpc_inputStickerSetID) {
-						document->sticker()->set = inputSet;
-					}
-				}
-				++set->count;
-			}
-		}
-
-		qint32 datesCount = 0;
-		stickers.stream >> datesCount;
-		if (datesCount > 0) {
-			if (datesCount != scnt) {
-				return failed();
-			}
-			const auto fillDates = (set->id == Stickers::CloudRecentSetId)
-				&& (set->stickers.size() == datesCount);
-			if (fillDates) {
-				set->dates.clear();
-				set->dates.reserve(datesCount);
-			}
-			for (auto i = 0; i != datesCount; ++i) {
-				qint32 date = 0;
-				stickers.stream >> date;
-				if (fillDates) {
-					set->dates.push_back(TimeId(date));
-				}
 			}
+			continue;
+		} else if (!fillStickers) {
+			// The set is already read from another list, skip its file.
+			continue;
+		} else if (deferBodies) {
+			set->count = scnt;
+			_pendingStickerSetBodies.emplace(
+				setId,
+				PendingStickerSetBody{ stickersKey, body.key, scnt });
+			continue;
 		}
 
-		qint32 emojiCount = 0;
-		stickers.stream >> emojiCount;
-		if (!_checkStreamStatus(stickers.stream) || emojiCount < 0) {
+		FileReadDescriptor setBody;
+		if (!ReadEncryptedFile(setBody, body.key)) {
 			return failed();
 		}
-		for (int32 j = 0; j < emojiCount; ++j) {
-			QString emojiString;
-			qint32 stickersCount;
-			stickers.stream >> emojiString >> stickersCount;
-			Stickers::Pack pack;
-			pack.reserve(stickersCount);
-			for (int32 k = 0; k < stickersCount; ++k) {
-				quint64 id;
-				stickers.stream >> id;
-				const auto doc = Auth().data().document(id);
-				if (!doc->sticker()) continue;
-
-				pack.push_back(doc);
-			}
-			if (fillStickers) {
-				if (auto emoji = Ui::Emoji::Find(emojiString)) {
-					emoji = emoji->original();
-					set->emoji.insert(emoji, pack);
-				}
-			}
+		qint32 bodyCount = 0;
+		setBody.stream >> bodyCount;
+		if (!_checkStreamStatus(setBody.stream)
+			|| bodyCount != scnt
+			|| !_readStickerSetBody(
+				setBody.stream,
+				setBody.version,
+				set,
+				bodyCount,
+				fillStickers)) {
+			return failed();
 		}
 	}
 
@@ -3983,25 +4236,37 @@ void importOldRecentStickers() {
 	_writeMap();
 }
 
+void _deferStickerSetBodies() {
+	if (!_pendingStickerSetBodies.empty()) {
+		Auth().data().setStickerSetsContentsLoader(
+			_readPendingStickerSetBodies);
+	}
+}
+
 void readInstalledStickers() {
 	if (!_installedStickersKey) {
 		return importOldRecentStickers();
 	}
 
-	Auth().data().stickerSetsRef().clear();
+	_pendingStickerSetBodies.clear();
+	Auth().data().stickerSetsInfoRef().clear();
 	_readStickerSets(
 		_installedStickersKey,
 		&Auth().data().stickerSetsOrderRef(),
-		MTPDstickerSet::Flag::f_installed_date);
+		MTPDstickerSet::Flag::f_installed_date,
+		true);
+	_deferStickerSetBodies();
 }
 
 void readFeaturedStickers() {
 	_readStickerSets(
 		_featuredStickersKey,
 		&Auth().data().featuredStickerSetsOrderRef(),
-		MTPDstickerSet::Flags() | MTPDstickerSet_ClientFlag::f_featured);
+		MTPDstickerSet::Flags() | MTPDstickerSet_ClientFlag::f_featured,
+		true);
+	_deferStickerSetBodies();
 
-	const auto &sets = Auth().data().stickerSets();
+	const auto &sets = Auth().data().stickerSetsInfo();
 	const auto &order = Auth().data().featuredStickerSetsOrder();
 	int unreadCount = 0;
 	for (const auto setId : order) {
@@ -4039,7 +4304,7 @@ int32 countDocumentVectorHash(const QVector<DocumentData*> vector) {
 }
 
 int32 countSpecialStickerSetHash(uint64 setId) {
-	const auto &sets = Auth().data().stickerSets();
+	const auto &sets = Auth().data().stickerSetsInfo();
 	const auto it = sets.find(setId);
 	if (it != sets.cend()) {
 		return countDocumentVectorHash(it->second->stickers);
@@ -4050,7 +4315,7 @@ int32 countSpecialStickerSetHash(uint64 setId) {
 int32 countStickersHash(bool checkOutdatedInfo) {
 	auto result = Api::HashInit();
 	bool foundOutdated = false;
-	const auto &sets = Auth().data().stickerSets();
+	const auto &sets = Auth().data().stickerSetsInfo();
 	const auto &order = Auth().data().stickerSetsOrder();
 	for (auto i = order.cbegin(), e = order.cend(); i != e; ++i) {
 		auto it = sets.find(*i);
@@ -4079,7 +4344,7 @@ int32 countFavedStickersHash() {
 
 int32 countFeaturedStickersHash() {
 	auto result = Api::HashInit();
-	const auto &sets = Auth().data().stickerSets();
+	const auto &sets = Auth().data().stickerSetsInfo();
 	const auto &featured = Auth().data().featuredStickerSetsOrder();
 	for (const auto setId : featured) {
 		Api::HashUpdate(result, setId);
@@ -5163,6 +5428,8 @@ bool ClearManager::addTask(int task) {
 		}
 		if (_installedStickersKey || _featuredStickersKey || _recentStickersKey || _archivedStickersKey) {
 			_installedStickersKey = _featuredStickersKey = _recentStickersKey = _archivedStickersKey = 0;
+			_stickerSetBodies.clear();
+			_pendingStickerSetBodies.clear();
 			_mapChanged = true;
 		}
 		if (_recentHashtagsAndBotsKey) {
@@ -15,11 +15,144 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include <QtCore/QSemaphore>
 #include <QtCore/QMimeData>
+#include <QtCore/QMutex>
 
 namespace Storage {
 namespace {
 
 constexpr auto kMaxAlbumCount = 10;
+constexpr auto kPreparedCacheBytes = 96 * 1024 * 1024;
+
+struct PreparedCacheKey {
+	QString path;
+	qint64 size = 0;
+	qint64 modified = 0;
+	int previewWidth = 0;
+
+	inline bool operator<(const PreparedCacheKey &other) const {
+		return std::tie(path, size, modified, previewWidth)
+			< std::tie(
+				other.path,
+				other.size,
+				other.modified,
+				other.previewWidth);
+	}
+};
+
+struct PreparedCacheEntry {
+	QString mime;
+	FileMediaInformation information;
+	QImage preview;
+	QSize shownDimensions;
+	PreparedFile::AlbumType type = PreparedFile::AlbumType::None;
+	int64 bytes = 0;
+	uint64 used = 0;
+};
+
+// Results of reading local files for the send files box, so that the
+// same files dropped or chosen again are shown without reading them.
+class PreparedCache final {
+public:
+	[[nodiscard]] bool apply(const PreparedCacheKey &key, PreparedFile &file);
+	void store(PreparedCacheKey &&key, const PreparedFile &file);
+
+private:
+	QMutex _mutex;
+	std::map<PreparedCacheKey, PreparedCacheEntry> _entries;
+	int64 _bytes = 0;
+	uint64 _used = 0;
+
+};
+
+[[nodiscard]] PreparedCache &GlobalPreparedCache() {
+	static auto result = PreparedCache();
+	return result;
+}
+
+[[nodiscard]] int64 ImageBytes(const QImage &image) {
+	return int64(image.bytesPerLine()) * image.height();
+}
+
+[[nodiscard]] int64 InformationBytes(const FileMediaInformation &data) {
+	using Image = FileMediaInformation::Image;
+	using Song = FileMediaInformation::Song;
+	using Video = FileMediaInformation::Video;
+	if (const auto image = base::get_if<Image>(&data.media)) {
+		return ImageBytes(image->data) + ImageBytes(image->thumbnail);
+	} else if (const auto song = base::get_if<Song>(&data.media)) {
+		return ImageBytes(song->cover);
+	} else if (const auto video = base::get_if<Video>(&data.media)) {
+		return ImageBytes(video->thumbnail);
+	}
+	return 0;
+}
+
+[[nodiscard]] std::optional<PreparedCacheKey> PreparedKey(
+		const PreparedFile &file,
+		int previewWidth) {
+	if (file.path.isEmpty() || !file.content.isEmpty()) {
+		return std::nullopt;
+	}
+	const auto info = QFileInfo(file.path);
+	if (!info.exists()) {
+		return std::nullopt;
+	}
+	return PreparedCacheKey{
+		info.absoluteFilePath(),
+		info.size(),
+		info.lastModified().toMSecsSinceEpoch(),
+		previewWidth * cIntRetinaFactor(),
+	};
+}
+
+bool PreparedCache::apply(const PreparedCacheKey &key, PreparedFile &file) {
+	QMutexLocker lock(&_mutex);
+	const auto i = _entries.find(key);
+	if (i == end(_entries)) {
+		return false;
+	}
+	auto &entry = i->second;
+	entry.used = ++_used;
+	file.mime = entry.mime;
+	file.information = std::make_unique<FileMediaInformation>(
+		entry.information);
+	file.preview = entry.preview;
+	file.shownDimensions = entry.shownDimensions;
+	file.type = entry.type;
+	return true;
+}
+
+void PreparedCache::store(PreparedCacheKey &&key, const PreparedFile &file) {
+	if (!file.information) {
+		return;
+	}
+	auto entry = PreparedCacheEntry{
+		file.mime,
+		*file.information,
+		file.preview,
+		file.shownDimensions,
+		file.type,
+	};
+	entry.bytes = InformationBytes(entry.information)
+		+ ImageBytes(entry.preview);
+	if (entry.bytes > kPreparedCacheBytes / 4) {
+		return;
+	}
+
+	QMutexLocker lock(&_mutex);
+	entry.used = ++_used;
+	auto &already = _entries[std::move(key)];
+	_bytes += entry.bytes - already.bytes;
+	already = std::move(entry);
+	while (_bytes > kPreparedCacheBytes) {
+		const auto oldest = ranges::min_element(
+			_entries,
+			ranges::less(),
+			[](const auto &pair) { return pair.second.used; });
+		_bytes -= oldest->second.bytes;
+		_entries.erase(oldest);
+	}
+}
 
 bool HasExtensionFrom(const QString &file, const QStringList &extensions) {
 	for (const auto &extension : extensions) {
@@ -65,6 +198,15 @@ bool PrepareAlbumMediaIsWaiting(
 	// TODO: Use some special thread queue, like a separate QThreadPool.
 	crl::async([=, &semaphore, &file] {
 		const auto guard = gsl::finally([&] { semaphore.release(); });
+		auto key = PreparedKey(file, previewWidth);
+		if (key && GlobalPreparedCache().apply(*key, file)) {
+			return;
+		}
+		const auto store = gsl::finally([&] {
+			if (key) {
+				GlobalPreparedCache().store(std::move(*key), file);
+			}
+		});
 		if (!file.path.isEmpty()) {
 			file.mime = Core::MimeTypeForFile(QFileInfo(file.path)).name();
 			file.information = FileLoadTask::ReadMediaInformation(
@@ -11,8 +11,13 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_session.h"
 #include "chat_helpers/stickers.h"
 #include "main/main_session.h"
+#include "main/main_account.h"
+#include "core/application.h"
 #include "app.h"
 
+#include <list>
+#include <unordered_map>
+
 using namespace Images;
 
 namespace Images {
@@ -28,6 +33,324 @@ namespace {
 	return PixKey(0, 0, options);
 }
 
+[[nodiscard]] bool IsSinglePixKey(uint64 key) {
+	return !(key & ((uint64(1) << 48) - 1));
+}
+
+[[nodiscard]] uint64 PixKeyOptions(uint64 key) {
+	return (key >> 48);
+}
+
+[[nodiscard]] int64 ImageBytes(const QImage &image) {
+	return int64(image.bytesPerLine()) * image.height();
+}
+
+constexpr auto kPixmapCacheBudget = int64(128 * 1024 * 1024);
+
+// All option bits set can't be a real pix key, it marks the LRU entry
+// of a blurred original.
+constexpr auto kBlurredOriginalKey = ~uint64(0);
+
+// Sources smaller than that are scaled fast enough to do it in paint.
+constexpr auto kAsyncSourceArea = 512 * 512;
+
+class PixmapCache final {
+public:
+	[[nodiscard]] static PixmapCache &Instance();
+
+	[[nodiscard]] const QPixmap *find(
+		not_null<const Image*> image,
+		uint64 key,
+		QSize required);
+	[[nodiscard]] const QPixmap *nearest(
+		not_null<const Image*> image,
+		uint64 key) const;
+	const QPixmap &store(
+		not_null<const Image*> image,
+		uint64 key,
+		QPixmap pixmap);
+
+	[[nodiscard]] uint64 startRequest(
+		not_null<const Image*> image,
+		uint64 key);
+	void finishRequest(
+		not_null<const Image*> image,
+		uint64 key,
+		uint64 requestId,
+		QImage result,
+		QImage blurred);
+
+	[[nodiscard]] QImage blurred(not_null<const Image*> image);
+	void storeBlurred(not_null<const Image*> image, QImage blurred);
+
+	void forget(not_null<const Image*> image);
+
+	[[nodiscard]] PixmapCacheStats stats() const;
+
+private:
+	struct Key {
+		const Image *image = nullptr;
+		uint64 key = 0;
+
+		inline bool operator==(const Key &other) const {
+			return (image == other.image) && (key == other.key);
+		}
+	};
+	struct KeyHash {
+		size_t operator()(const Key &value) const {
+			return std::hash<const Image*>()(value.image)
+				^ std::hash<uint64>()(value.key);
+		}
+	};
+	struct Entry {
+		QPixmap pixmap;
+		std::list<Key>::iterator lru;
+		int64 bytes = 0;
+	};
+	struct BlurredEntry {
+		QImage image;
+		std::list<Key>::iterator lru;
+	};
+
+	void remove(const Key &key);
+	void removeBlurred(not_null<const Image*> image);
+	void scheduleTrim();
+	void trim();
+
+	// Entries are never moved, so references returned from Image::pix*
+	// stay valid until the entry is evicted after the current paint.
+	std::unordered_map<Key, Entry, KeyHash> _entries;
+	std::unordered_map<const Image*, base::flat_set<uint64>> _keysByImage;
+	std::unordered_map<Key, uint64, KeyHash> _pending;
+
+	// Blurred originals, all blurred variants are scaled from them.
+	std::unordered_map<const Image*, BlurredEntry> _blurred;
+	std::list<Key> _lru;
+	uint64 _requestId = 0;
+	int64 _bytes = 0;
+	int64 _hits = 0;
+	int64 _misses = 0;
+	int64 _placeholders = 0;
+	bool _trimScheduled = false;
+
+};
+
+PixmapCache &PixmapCache::Instance() {
+	// Never destroyed, static Image instances may outlive it otherwise.
+	static const auto result = new PixmapCache();
+	return *result;
+}
+
+const QPixmap *PixmapCache::find(
+		not_null<const Image*> image,
+		uint64 key,
+		QSize required) {
+	const auto full = Key{ image, key };
+	const auto i = _entries.find(full);
+	if (i == end(_entries)
+		|| (!required.isEmpty() && i->second.pixmap.size() != required)
+		|| (required.isEmpty() && IsSinglePixKey(key))) {
+		++_misses;
+		return nullptr;
+	}
+	_lru.splice(begin(_lru), _lru, i->second.lru);
+	if (_pending.find(full) != end(_pending)) {
+		++_placeholders;
+	} else {
+		++_hits;
+	}
+	return &i->second.pixmap;
+}
+
+const QPixmap *PixmapCache::nearest(
+		not_null<const Image*> image,
+		uint64 key) const {
+	const auto keys = _keysByImage.find(image);
+	if (keys == end(_keysByImage) || IsSinglePixKey(key)) {
+		return nullptr;
+	}
+	const auto options = PixKeyOptions(key);
+	const auto area = [](const QPixmap &pixmap) {
+		return int64(pixmap.width()) * pixmap.height();
+	};
+	const QPixmap *result = nullptr;
+	for (const auto other : keys->second) {
+		if (IsSinglePixKey(other)
+			|| PixKeyOptions(other) != options
+			|| _pending.find(Key{ image, other }) != end(_pending)) {
+			continue;
+		}
+		const auto &pixmap = _entries.find(Key{ image, other })->second.pixmap;
+		if (!result || area(*result) < area(pixmap)) {
+			result = &pixmap;
+		}
+	}
+	return result;
+}
+
+const QPixmap &PixmapCache::store(
+		not_null<const Image*> image,
+		uint64 key,
+		QPixmap pixmap) {
+	const auto full = Key{ image, key };
+	const auto bytes = int64(pixmap.width()) * pixmap.height() * 4;
+	auto i = _entries.find(full);
+	if (i == end(_entries)) {
+		_lru.push_front(full);
+		i = _entries.emplace(full, Entry{ QPixmap(), begin(_lru) }).first;
+		_keysByImage[image].emplace(key);
+	} else {
+		_lru.splice(begin(_lru), _lru, i->second.lru);
+		_bytes -= i->second.bytes;
+	}
+	i->second.pixmap = std::move(pixmap);
+	i->second.bytes = bytes;
+	_bytes += bytes;
+	if (_bytes > kPixmapCacheBudget) {
+		scheduleTrim();
+	}
+	return i->second.pixmap;
+}
+
+uint64 PixmapCache::startRequest(
+		not_null<const Image*> image,
+		uint64 key) {
+	const auto result = ++_requestId;
+	_pending[Key{ image, key }] = result;
+	return result;
+}
+
+void PixmapCache::finishRequest(
+		not_null<const Image*> image,
+		uint64 key,
+		uint64 requestId,
+		QImage result,
+		QImage blurred) {
+	const auto full = Key{ image, key };
+	const auto i = _pending.find(full);
+	if (i == end(_pending) || i->second != requestId) {
+		return;
+	}
+	_pending.erase(i);
+	if (!blurred.isNull()) {
+		storeBlurred(image, std::move(blurred));
+	}
+	auto pixmap = App::pixmapFromImageInPlace(std::move(result));
+	pixmap.setDevicePixelRatio(cRetinaFactor());
+	store(image, key, std::move(pixmap));
+
+	auto &account = Core::App().activeAccount();
+	if (account.sessionExists()) {
+		account.session().downloaderTaskFinished().notify();
+	}
+}
+
+QImage PixmapCache::blurred(not_null<const Image*> image) {
+	const auto i = _blurred.find(image);
+	if (i == end(_blurred)) {
+		return QImage();
+	}
+	_lru.splice(begin(_lru), _lru, i->second.lru);
+	return i->second.image;
+}
+
+void PixmapCache::storeBlurred(not_null<const Image*> image, QImage blurred) {
+	auto i = _blurred.find(image);
+	if (i == end(_blurred)) {
+		_lru.push_front(Key{ image, kBlurredOriginalKey });
+		i = _blurred.emplace(
+			image,
+			BlurredEntry{ QImage(), begin(_lru) }).first;
+	} else {
+		_lru.splice(begin(_lru), _lru, i->second.lru);
+		_bytes -= ImageBytes(i->second.image);
+	}
+	i->second.image = std::move(blurred);
+	_bytes += ImageBytes(i->second.image);
+	if (_bytes > kPixmapCacheBudget) {
+		scheduleTrim();
+	}
+}
+
+void PixmapCache::removeBlurred(not_null<const Image*> image) {
+	const auto i = _blurred.find(image);
+	if (i != end(_blurred)) {
+		_bytes -= ImageBytes(i->second.image);
+		_lru.erase(i->second.lru);
+		_blurred.erase(i);
+	}
+}
+
+void PixmapCache::forget(not_null<const Image*> image) {
+	removeBlurred(image);
+	const auto keys = _keysByImage.find(image);
+	if (keys == end(_keysByImage)) {
+		return;
+	}
+	for (const auto key : base::take(keys->second)) {
+		const auto full = Key{ image, key };
+		const auto i = _entries.find(full);
+		_bytes -= i->second.bytes;
+		_lru.erase(i->second.lru);
+		_entries.erase(i);
+		_pending.erase(full);
+	}
+	_keysByImage.erase(keys);
+}
+
+void PixmapCache::remove(const Key &key) {
+	if (key.key == kBlurredOriginalKey) {
+		removeBlurred(key.image);
+		return;
+	}
+	const auto i = _entries.find(key);
+	if (i == end(_entries)) {
+		return;
+	}
+	_bytes -= i->second.bytes;
+	_lru.erase(i->second.lru);
+	_entries.erase(i);
+	_pending.erase(key);
+
+	const auto keys = _keysByImage.find(key.image);
+	keys->second.remove(key.key);
+	if (keys->second.empty()) {
+		_keysByImage.erase(keys);
+		removeBlurred(key.image);
+	}
+}
+
+void PixmapCache::scheduleTrim() {
+	if (_trimScheduled) {
+		return;
+	}
+	_trimScheduled = true;
+
+	// Paint code may still hold references to the evicted pixmaps.
+	crl::on_main([=] { trim(); });
+}
+
+void PixmapCache::trim() {
+	_trimScheduled = false;
+	while (_bytes > kPixmapCacheBudget && _lru.size() > 1) {
+		// Copy the key, remove() erases the list node it points to.
+		const auto key = _lru.back();
+		remove(key);
+	}
+}
+
+PixmapCacheStats PixmapCache::stats() const {
+	auto result = PixmapCacheStats();
+	result.hits = _hits;
+	result.misses = _misses;
+	result.placeholders = _placeholders;
+	result.bytes = _bytes;
+	result.budget = kPixmapCacheBudget;
+	result.entries = int(_entries.size());
+	result.pending = int(_pending.size());
+	return result;
+}
+
 [[nodiscard]] QByteArray ReadContent(const QString &path) {
 	auto file = QFile(path);
 	const auto good = (file.size() <= App::kImageSizeLimit)
@@ -104,6 +427,10 @@ QSize GetSizeForDocument(const QVector<MTPDocumentAttribute> &attributes) {
 	return QSize();
 }
 
+PixmapCacheStats GetPixmapCacheStats() {
+	return PixmapCache::Instance().stats();
+}
+
 } // namespace Images
 
 Image::Image(const QString &path) : Image(ReadContent(path)) {
@@ -117,6 +444,10 @@ Image::Image(QImage &&data)
 	Expects(!_data.isNull());
 }
 
+Image::~Image() {
+	PixmapCache::Instance().forget(this);
+}
+
 not_null<Image*> Image::Empty() {
 	static auto result = Image([] {
 		const auto factor = cIntRetinaFactor();
@@ -157,14 +488,7 @@ const QPixmap &Image::pix(int w, int h) const {
 		h *= cIntRetinaFactor();
 	}
 	auto options = Option::Smooth | Option::None;
-	auto k = PixKey(w, h, options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend()) {
-		auto p = pixNoCache(w, h, options);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
-	}
-	return i->second;
+	return cachedAsync(PixKey(w, h, options), w, h, options);
 }
 
 const QPixmap &Image::pixRounded(
@@ -192,14 +516,7 @@ const QPixmap &Image::pixRounded(
 	} else if (radius == ImageRoundRadius::Ellipse) {
 		options |= Option::Circled | cornerOptions(corners);
 	}
-	auto k = PixKey(w, h, options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend()) {
-		auto p = pixNoCache(w, h, options);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
-	}
-	return i->second;
+	return cachedAsync(PixKey(w, h, options), w, h, options);
 }
 
 const QPixmap &Image::pixCircled(int w, int h) const {
@@ -210,14 +527,7 @@ const QPixmap &Image::pixCircled(int w, int h) const {
 		h *= cIntRetinaFactor();
 	}
 	auto options = Option::Smooth | Option::Circled;
-	auto k = PixKey(w, h, options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend()) {
-		auto p = pixNoCache(w, h, options);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
-	}
-	return i->second;
+	return cachedAsync(PixKey(w, h, options), w, h, options);
 }
 
 const QPixmap &Image::pixBlurredCircled(int w, int h) const {
@@ -228,14 +538,7 @@ const QPixmap &Image::pixBlurredCircled(int w, int h) const {
 		h *= cIntRetinaFactor();
 	}
 	auto options = Option::Smooth | Option::Circled | Option::Blurred;
-	auto k = PixKey(w, h, options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend()) {
-		auto p = pixNoCache(w, h, options);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
-	}
-	return i->second;
+	return cachedAsync(PixKey(w, h, options), w, h, options);
 }
 
 const QPixmap &Image::pixBlurred(int w, int h) const {
@@ -246,14 +549,7 @@ const QPixmap &Image::pixBlurred(int w, int h) const {
 		h *= cIntRetinaFactor();
 	}
 	auto options = Option::Smooth | Option::Blurred;
-	auto k = PixKey(w, h, options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend()) {
-		auto p = pixNoCache(w, h, options);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
-	}
-	return i->second;
+	return cachedAsync(PixKey(w, h, options), w, h, options);
 }
 
 const QPixmap &Image::pixColored(style::color add, int w, int h) const {
@@ -264,14 +560,9 @@ const QPixmap &Image::pixColored(style::color add, int w, int h) const {
 		h *= cIntRetinaFactor();
 	}
 	auto options = Option::Smooth | Option::Colored;
-	auto k = PixKey(w, h, options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend()) {
-		auto p = pixColoredNoCache(add, w, h, true);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
-	}
-	return i->second;
+	return cached(PixKey(w, h, options), QSize(), [&] {
+		return pixColoredNoCache(add, w, h, true);
+	});
 }
 
 const QPixmap &Image::pixBlurredColored(
@@ -285,14 +576,9 @@ const QPixmap &Image::pixBlurredColored(
 		h *= cIntRetinaFactor();
 	}
 	auto options = Option::Blurred | Option::Smooth | Option::Colored;
-	auto k = PixKey(w, h, options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend()) {
-		auto p = pixBlurredColoredNoCache(add, w, h);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
-	}
-	return i->second;
+	return cached(PixKey(w, h, options), QSize(), [&] {
+		return pixBlurredColoredNoCache(add, w, h);
+	});
 }
 
 const QPixmap &Image::pixSingle(
@@ -326,16 +612,12 @@ const QPixmap &Image::pixSingle(
 	}
 	if (colored) {
 		options |= Option::Colored;
+		const auto required = QSize(outerw, outerh) * cIntRetinaFactor();
+		return cached(SinglePixKey(options), required, [&] {
+			return pixNoCache(w, h, options, outerw, outerh, colored);
+		});
 	}
-
-	auto k = SinglePixKey(options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend() || i->second.width() != (outerw * cIntRetinaFactor()) || i->second.height() != (outerh * cIntRetinaFactor())) {
-		auto p = pixNoCache(w, h, options, outerw, outerh, colored);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
-	}
-	return i->second;
+	return cachedAsync(SinglePixKey(options), w, h, options, outerw, outerh);
 }
 
 const QPixmap &Image::pixBlurredSingle(
@@ -367,14 +649,110 @@ const QPixmap &Image::pixBlurredSingle(
 		options |= Option::Circled | cornerOptions(corners);
 	}
 
-	auto k = SinglePixKey(options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend() || i->second.width() != (outerw * cIntRetinaFactor()) || i->second.height() != (outerh * cIntRetinaFactor())) {
-		auto p = pixNoCache(w, h, options, outerw, outerh);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
+	return cachedAsync(SinglePixKey(options), w, h, options, outerw, outerh);
+}
+
+const QPixmap &Image::cached(
+		uint64 key,
+		QSize required,
+		FnMut<QPixmap()> render) const {
+	auto &cache = PixmapCache::Instance();
+	if (const auto result = cache.find(this, key, required)) {
+		return *result;
+	}
+	auto pixmap = render();
+	pixmap.setDevicePixelRatio(cRetinaFactor());
+	return cache.store(this, key, std::move(pixmap));
+}
+
+const QPixmap &Image::cachedAsync(
+		uint64 key,
+		int w,
+		int h,
+		Options options,
+		int outerw,
+		int outerh) const {
+	const auto required = IsSinglePixKey(key)
+		? (QSize(outerw, outerh) * cIntRetinaFactor())
+		: QSize();
+	if (isNull() || (width() * height() < kAsyncSourceArea)) {
+		return cached(key, required, [&] {
+			return pixNoCache(w, h, options, outerw, outerh);
+		});
+	}
+	auto &cache = PixmapCache::Instance();
+	if (const auto result = cache.find(this, key, required)) {
+		return *result;
+	}
+
+	const auto requestId = cache.startRequest(this, key);
+	const auto blurred = (options & Option::Blurred)
+		? cache.blurred(this)
+		: QImage();
+	crl::async([=, image = this, data = _data] {
+		auto source = blurred.isNull() ? data : blurred;
+		auto blurredSource = QImage();
+		if ((options & Option::Blurred) && blurred.isNull()) {
+			source = blurredSource = prepareBlur(std::move(source));
+		}
+		auto result = prepare(
+			std::move(source),
+			w,
+			h,
+			options & ~Option::Blurred,
+			outerw,
+			outerh,
+			nullptr);
+		crl::on_main([
+			=,
+			result = std::move(result),
+			blurredSource = std::move(blurredSource)
+		]() mutable {
+			PixmapCache::Instance().finishRequest(
+				image,
+				key,
+				requestId,
+				std::move(result),
+				std::move(blurredSource));
+		});
+	});
+
+	auto placeholder = pixPlaceholder(key, w, h, options, outerw, outerh);
+	placeholder.setDevicePixelRatio(cRetinaFactor());
+	return cache.store(this, key, std::move(placeholder));
+}
+
+QPixmap Image::pixPlaceholder(
+		uint64 key,
+		int w,
+		int h,
+		Options options,
+		int outerw,
+		int outerh) const {
+	const auto height = (h > 0)
+		? h
+		: std::max(int(int64(w) * this->height() / width()), 1);
+	if (const auto nearest = PixmapCache::Instance().nearest(this, key)) {
+		return nearest->scaled(
+			w,
+			height,
+			Qt::IgnoreAspectRatio,
+			Qt::FastTransformation);
 	}
-	return i->second;
+	// Never prepare the full source here, even a slightly larger one.
+	// The fast scale leaves work proportional to the target size only.
+	return App::pixmapFromImageInPlace(prepare(
+		_data.scaled(
+			w,
+			height,
+			Qt::IgnoreAspectRatio,
+			Qt::FastTransformation),
+		w,
+		h,
+		options & ~Option::Smooth,
+		outerw,
+		outerh,
+		nullptr));
 }
 
 QPixmap Image::pixNoCache(
@@ -431,9 +809,29 @@ QPixmap Image::pixNoCache(
 		return App::pixmapFromImageInPlace(std::move(result));
 	}
 
+	if (options & Option::Blurred) {
+		return App::pixmapFromImageInPlace(prepare(
+			blurredOriginal(),
+			w,
+			h,
+			options & ~Option::Blurred,
+			outerw,
+			outerh,
+			colored));
+	}
 	return App::pixmapFromImageInPlace(prepare(_data, w, h, options, outerw, outerh, colored));
 }
 
+QImage Image::blurredOriginal() const {
+	auto &cache = PixmapCache::Instance();
+	auto result = cache.blurred(this);
+	if (result.isNull()) {
+		result = prepareBlur(_data);
+		cache.storeBlurred(this, result);
+	}
+	return result;
+}
+
 QPixmap Image::pixColoredNoCache(
 		style::color add,
 		int w,
@@ -461,7 +859,7 @@ QPixmap Image::pixBlurredColoredNoCache(
 		return Empty()->pix();
 	}
 
-	auto img = prepareBlur(_data);
+	auto img = blurredOriginal();
 	if (h <= 0) {
 		img = img.scaledToWidth(w, Qt::SmoothTransformation);
 	} else {
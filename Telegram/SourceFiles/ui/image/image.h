@@ -17,6 +17,19 @@ namespace Images {
 [[nodiscard]] QSize GetSizeForDocument(
 	const QVector<MTPDocumentAttribute> &attributes);
 
+struct PixmapCacheStats {
+	int64 hits = 0;
+	int64 misses = 0;
+	int64 placeholders = 0;
+	int64 bytes = 0;
+	int64 budget = 0;
+	int entries = 0;
+	int pending = 0;
+};
+
+// All Image::pix* variants live in one process-wide LRU cache.
+[[nodiscard]] PixmapCacheStats GetPixmapCacheStats();
+
 } // namespace Images
 
 class Image final {
@@ -24,6 +37,7 @@ public:
 	explicit Image(const QString &path);
 	explicit Image(const QByteArray &content);
 	explicit Image(QImage &&data);
+	~Image();
 
 	[[nodiscard]] static not_null<Image*> Empty(); // 1x1 transparent
 	[[nodiscard]] static not_null<Image*> BlankMedia(); // 1x1 black
@@ -91,7 +105,26 @@ public:
 		int h = 0) const;
 
 private:
+	[[nodiscard]] const QPixmap &cached(
+		uint64 key,
+		QSize required,
+		FnMut<QPixmap()> render) const;
+	[[nodiscard]] const QPixmap &cachedAsync(
+		uint64 key,
+		int w,
+		int h,
+		Images::Options options,
+		int outerw = -1,
+		int outerh = -1) const;
+	[[nodiscard]] QPixmap pixPlaceholder(
+		uint64 key,
+		int w,
+		int h,
+		Images::Options options,
+		int outerw,
+		int outerh) const;
+	[[nodiscard]] QImage blurredOriginal() const;
+
 	const QImage _data;
-	mutable base::flat_map<uint64, QPixmap> _cache;
 
 };
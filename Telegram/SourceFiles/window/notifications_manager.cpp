@@ -43,6 +43,10 @@ constexpr auto kSystemAlertDuration = crl::time(1000);
 constexpr auto kSystemAlertDuration = crl::time(0);
 #endif // Q_OS_MAC
 
+[[nodiscard]] bool CanCoalesce(not_null<HistoryItem*> item) {
+	return !item->Has<HistoryMessageForwarded>() && !item->groupId();
+}
+
 } // namespace
 
 System::System(not_null<Main::Session*> session)
@@ -134,6 +138,9 @@ void System::schedule(not_null<HistoryItem*> item) {
 		_whenAlerts[history].insert(when, notifyBy);
 	}
 	if (Global::DesktopNotify() && !Platform::Notifications::SkipToast()) {
+		if (CanCoalesce(item)) {
+			when = coalesceBurst(item, when);
+		}
 		auto &whenMap = _whenMaps[history];
 		if (whenMap.constFind(item->id) == whenMap.cend()) {
 			whenMap.insert(item->id, when);
@@ -152,6 +159,34 @@ void System::schedule(not_null<HistoryItem*> item) {
 	}
 }
 
+// Pending notifications from the same chat that should be shown within
+// the burst window are replaced by the new one, shown at the earliest time.
+crl::time System::coalesceBurst(not_null<HistoryItem*> item, crl::time when) {
+	const auto history = item->history();
+	const auto j = _whenMaps.find(history);
+	if (j == _whenMaps.end()) {
+		return when;
+	}
+	const auto window = crl::time(Global::NotifyBurstWindow());
+	auto &whenMap = j.value();
+	for (auto i = whenMap.begin(); i != whenMap.end();) {
+		const auto pending = history->owner().message(
+			history->channelId(),
+			i.key());
+		if (pending
+			&& pending != item
+			&& CanCoalesce(pending)
+			&& when - i.value() <= window) {
+			when = std::min(when, i.value());
+			history->removeNotification(pending);
+			i = whenMap.erase(i);
+		} else {
+			++i;
+		}
+	}
+	return when;
+}
+
 void System::clearAll() {
 	_manager->clearAll();
 
@@ -100,6 +100,7 @@ private:
 
 	SkipState skipNotification(not_null<HistoryItem*> item) const;
 
+	crl::time coalesceBurst(not_null<HistoryItem*> item, crl::time when);
 	void showNext();
 	void showGrouped();
 	void ensureSoundCreated();
@@ -307,7 +307,30 @@ void Manager::removeWidget(internal::Widget *remove) {
 void Manager::doShowNotification(
 		not_null<HistoryItem*> item,
 		int forwardedCount) {
-	_queuedNotifications.emplace_back(item, forwardedCount);
+	auto queued = QueuedNotification(item, forwardedCount);
+
+	// Bursts from one chat update a single notification in place
+	// instead of creating a new window for each message.
+	for (const auto &notification : _notifications) {
+		const auto reused = notification->reuse(
+			queued.history,
+			queued.author,
+			queued.item,
+			queued.forwardedCount,
+			queued.fromScheduled);
+		if (reused) {
+			return;
+		}
+	}
+	const auto i = ranges::find(
+		_queuedNotifications,
+		queued.history,
+		&QueuedNotification::history);
+	if (i != end(_queuedNotifications)) {
+		*i = std::move(queued);
+		return;
+	}
+	_queuedNotifications.push_back(std::move(queued));
 	showNextFromQueue();
 }
 
@@ -819,6 +842,29 @@ void Notification::updatePeerPhoto() {
 	update();
 }
 
+bool Notification::reuse(
+		not_null<History*> history,
+		const QString &author,
+		HistoryItem *item,
+		int forwardedCount,
+		bool fromScheduled) {
+	if (_history != history || isReplying() || isHiding()) {
+		return false;
+	}
+	_author = author;
+	_item = item;
+	_forwardedCount = forwardedCount;
+	_fromScheduled = fromScheduled;
+	_started = crl::now();
+	if (!_waitingForInput) {
+		_hideTimer.start(st::notifyWaitLongHide);
+	}
+	hideStop();
+	updateNotifyDisplay();
+	update();
+	return true;
+}
+
 bool Notification::unlinkItem(HistoryItem *deleted) {
 	auto unlink = (_item && _item == deleted);
 	if (unlink) {
@@ -128,6 +128,9 @@ public:
 	bool isShowing() const {
 		return _a_opacity.animating() && !_hiding;
 	}
+	bool isHiding() const {
+		return _hiding || _deleted;
+	}
 
 	void updateOpacity();
 	void changeShift(int top);
@@ -209,6 +212,12 @@ public:
 	}
 
 	// Called only by Manager.
+	bool reuse(
+		not_null<History*> history,
+		const QString &author,
+		HistoryItem *item,
+		int forwardedCount,
+		bool fromScheduled);
 	bool unlinkItem(HistoryItem *del);
 	bool unlinkHistory(History *history = nullptr);
 	bool checkLastInput(bool hasReplyingNotifications);
@@ -93,8 +93,8 @@ void SectionWidget::PaintBackground(not_null<QWidget*> widget, QRect clip) {
 		return;
 	}
 	auto fromy = App::main()->backgroundFromY();
-	auto x = 0, y = 0;
-	auto cached = App::main()->cachedBackground(fill, x, y);
+	auto to = QRect();
+	auto cached = App::main()->cachedBackground(fill, to);
 	if (cached.isNull()) {
 		if (Window::Theme::Background()->tile()) {
 			auto &pix = Window::Theme::Background()->pixmapForTiled();
@@ -122,8 +122,10 @@ void SectionWidget::PaintBackground(not_null<QWidget*> widget, QRect clip) {
 			to.moveTop(to.top() + fromy);
 			p.drawPixmap(to, pix, from);
 		}
+	} else if (to.size() * cIntRetinaFactor() == cached.size()) {
+		p.drawPixmap(to.x(), fromy + to.y(), cached);
 	} else {
-		p.drawPixmap(x, fromy + y, cached);
+		p.drawPixmap(to.translated(0, fromy), cached);
 	}
 }
 
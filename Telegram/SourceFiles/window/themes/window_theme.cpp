@@ -359,9 +359,10 @@ bool LoadTheme(
 	return true;
 }
 
-bool InitializeFromCache(
+bool LoadFromCache(
 		const QByteArray &content,
-		const Cached &cache) {
+		const Cached &cache,
+		Instance *out = nullptr) {
 	if (cache.paletteChecksum != style::palette::Checksum()) {
 		return false;
 	}
@@ -381,12 +382,19 @@ bool InitializeFromCache(
 		}
 	}
 
-	if (!style::main_palette::load(cache.colors)) {
-		return false;
+	if (out) {
+		if (!out->palette.load(cache.colors)) {
+			return false;
+		}
+		out->cached = cache;
+	} else {
+		if (!style::main_palette::load(cache.colors)) {
+			return false;
+		}
+		Background()->saveAdjustableColors();
 	}
-	Background()->saveAdjustableColors();
 	if (!background.isNull()) {
-		applyBackground(std::move(background), cache.tiled, nullptr);
+		applyBackground(std::move(background), cache.tiled, out);
 	}
 
 	return true;
@@ -409,7 +417,7 @@ bool InitializeFromSaved(Saved &&saved) {
 
 	const auto editing = ReadEditingPalette();
 	GlobalBackground.createIfNull();
-	if (!editing && InitializeFromCache(saved.object.content, saved.cache)) {
+	if (!editing && LoadFromCache(saved.object.content, saved.cache)) {
 		return true;
 	}
 
@@ -1073,13 +1081,17 @@ void ChatBackground::reapplyWithNightMode(
 		}
 		auto preview = std::make_unique<Preview>();
 		preview->object = std::move(read.object);
-		preview->instance.cached = std::move(read.cache);
-		const auto loaded = LoadTheme(
+
+		// Switching to a theme we've already applied doesn't parse it.
+		const auto loaded = LoadFromCache(
 			preview->object.content,
-			ColorizerForTheme(path),
-			std::nullopt,
-			&preview->instance.cached,
-			&preview->instance);
+			read.cache,
+			&preview->instance) || LoadTheme(
+				preview->object.content,
+				ColorizerForTheme(path),
+				std::nullopt,
+				&preview->instance.cached,
+				&preview->instance);
 		if (!loaded) {
 			return false;
 		}
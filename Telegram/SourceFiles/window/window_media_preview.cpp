@@ -239,9 +239,10 @@ QSize MediaPreviewWidget::currentDimensions() const {
 void MediaPreviewWidget::setupLottie() {
 	Expects(_document != nullptr);
 
-	_lottie = std::make_unique<Lottie::SinglePlayer>(
-		Lottie::ReadContent(_documentMedia->bytes(), _document->filepath()),
-		Lottie::FrameRequest{ currentDimensions() * cIntRetinaFactor() },
+	_lottie = Stickers::LottiePlayerFromDocument(
+		_documentMedia.get(),
+		Stickers::LottieSize::MediaPreview,
+		currentDimensions() * cIntRetinaFactor(),
 		Lottie::Quality::High);
 
 	_lottie->updates(
@@ -23,6 +23,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_channel.h"
 #include "data/data_chat.h"
 #include "data/data_chat_filters.h"
+#include "data/data_histories.h"
 #include "passport/passport_form_controller.h"
 #include "chat_helpers/tabbed_selector.h"
 #include "core/shortcuts.h"
@@ -267,6 +268,9 @@ void SessionController::setActiveChatEntry(Dialogs::RowDescriptor row) {
 	if (now) {
 		now->setFakeUnreadWhileOpened(true);
 	}
+	if (was != now) {
+		session().data().histories().setShown(now);
+	}
 	if (session().supportMode()) {
 		pushToChatEntryHistory(row);
 	}